@@ -8,9 +8,14 @@
 #include <queue>
 #include <fstream>
 #include <map>
+#include <set>
+#include <chrono>
 
 #include "zpacker.hpp"
 //#include "zpacker_20.hpp"
+#include "zpacker_mmap.hpp"
+#include "zpacker_stream.hpp"
+#include "zpacker_parallel.hpp"
 
 struct Row
 {
@@ -61,6 +66,34 @@ struct Row
     }
 };
 
+// get_size() leaves out `tag`, it reports fewer bytes than serialize() writes
+struct TaggedRow
+{
+    uint32_t id;
+    std::string tag;
+
+    std::size_t get_size() const
+    {
+        return zpacker::get_size(id);
+    }
+
+    template <class _Writer>
+    void serialize(_Writer &writer) const
+    {
+        writer << id << tag;
+    }
+
+    template <class _Reader>
+    static TaggedRow deserialize(_Reader &reader)
+    {
+        TaggedRow self{};
+
+        reader >> self.id >> self.tag;
+
+        return self;
+    }
+};
+
 struct Complicated
 {
     Complicated()
@@ -118,13 +151,12 @@ struct Streamable
 
     friend std::ostream& operator << (std::ostream& s, const Streamable& o)
     {
-        std::vector<uint8_t> serialized{};
-
-        zpacker::bytes_writer writer{serialized};
+        // the object goes through a fixed-size buffer, it is never built in memory as a whole
+        zpacker::stream_writer writer{s};
 
         zpacker::serialize_object(writer, o);
 
-        return s.write(reinterpret_cast<const char*>(serialized.data()), serialized.size());
+        return s;
     }
 };
 
@@ -265,6 +297,369 @@ void get_size_example()
     printf("size1 = %zd, size2 = %zd, size3 = %zd, size4 = %zd\n", size1, size2, size3, size4);
 }
 
+template <class _Ty>
+bool check_exact_size(const char *name, const _Ty &object)
+{
+    std::vector<uint8_t> buffer;
+
+    zpacker::bytes_writer writer{buffer};
+
+    zpacker::serialize_object(writer, object);
+
+    auto size = zpacker::get_size(object);
+
+    /* the presized output must be byte-identical to the growing one */
+    auto packed = zpacker::serialize(zpacker::exact_size, object, zpacker::crc32_checksum{});
+
+    bool passed = size == buffer.size() && packed == zpacker::serialize(object, zpacker::crc32_checksum{});
+
+    printf("%-24s get_size = %zd, written = %zd, %s\n", name, size, buffer.size(), passed ? "ok" : "MISMATCH");
+
+    return passed;
+}
+
+void exact_size_example()
+{
+    check_exact_size("arithmetic", 3.1415926);
+    check_exact_size("std::array", std::array<int, 5>{1, 2, 3, 4, 5});
+    check_exact_size("std::vector<int>", std::vector<int>{1, 2, 3, 4});
+    check_exact_size("std::wstring", std::wstring{L"serialization"});
+    check_exact_size("std::forward_list", std::forward_list<std::string>{"Bob", "Element"});
+    check_exact_size("std::pair", std::pair<int, std::string>{1, "Jacky"});
+    check_exact_size("std::tuple", std::tuple<int, std::wstring, std::vector<std::string>, float>{8, L"Bob", {"Jacky", "Element"}, 3.14f});
+    check_exact_size("std::variant", std::variant<std::list<int>, long, float, char>{std::list<int>{1, 2}});
+    check_exact_size("std::map", std::map<uint32_t, std::string>{{1, "Jacky"}, {2, "Bob"}});
+    check_exact_size("custom get_size", Complicated{});
+}
+
+/* allocator that counts every allocation made by a container */
+template <class _Ty>
+struct counting_allocator
+{
+    using value_type = _Ty;
+
+    static inline size_t allocations = 0;
+
+    counting_allocator() = default;
+
+    template <class _Other>
+    counting_allocator(const counting_allocator<_Other> &) {}
+
+    _Ty *allocate(size_t n)
+    {
+        ++counting_allocator<void>::allocations;
+
+        return std::allocator<_Ty>{}.allocate(n);
+    }
+
+    void deallocate(_Ty *p, size_t n)
+    {
+        std::allocator<_Ty>{}.deallocate(p, n);
+    }
+
+    template <class _Other>
+    bool operator==(const counting_allocator<_Other> &) const { return true; }
+
+    template <class _Other>
+    bool operator!=(const counting_allocator<_Other> &) const { return false; }
+};
+
+void reserve_benchmark()
+{
+    using counted_map = std::unordered_map<std::string, uint32_t, std::hash<std::string>, std::equal_to<std::string>,
+                                           counting_allocator<std::pair<const std::string, uint32_t>>>;
+
+    constexpr uint32_t entries = 1000000;
+
+    std::unordered_map<std::string, uint32_t> map1{};
+
+    for (uint32_t i = 0; i < entries; ++i)
+        map1.emplace("key_" + std::to_string(i), i);
+
+    auto data = zpacker::serialize(map1);
+
+    /* growing insertion, what deserialization did before reserving */
+    counting_allocator<void>::allocations = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    counted_map grown{};
+
+    std::for_each(map1.begin(), map1.end(), [&grown](const auto &v)
+                  { grown.insert(v); });
+
+    auto grown_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    auto grown_allocations = counting_allocator<void>::allocations;
+
+    /* deserialization reserves the buckets from the element count up front */
+    counting_allocator<void>::allocations = 0;
+
+    start = std::chrono::steady_clock::now();
+
+    auto object = zpacker::deserialize<counted_map>(data);
+
+    auto reserved_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    auto reserved_allocations = counting_allocator<void>::allocations;
+
+    printf("%u entries: growing insert %zd allocations (%zd bucket arrays), %.1f ms\n",
+           entries, grown_allocations, grown_allocations - entries, grown_ms);
+    printf("%u entries: deserialize    %zd allocations (%zd bucket arrays), %.1f ms\n",
+           entries, reserved_allocations, reserved_allocations - object.size(), reserved_ms);
+}
+
+void compression_example()
+{
+    std::map<std::string, std::string> config{};
+
+    for (uint32_t i = 0; i < 50000; ++i)
+        config.emplace("section_" + std::to_string(i % 100) + ".key_" + std::to_string(i), "enabled=true;timeout=30;retries=" + std::to_string(i % 5));
+
+    auto plain = zpacker::serialize(config, zpacker::crc32c_checksum{});
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto packed = zpacker::serialize(config, zpacker::crc32c_checksum{}, zpacker::lz4_encoder{});
+
+    auto encode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    auto object = zpacker::deserialize<std::map<std::string, std::string>>(packed, zpacker::crc32c_checksum{}, zpacker::lz4_decoder{});
+
+    auto decode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("lz4: %zd -> %zd bytes, serialize %.1f ms, deserialize %.1f ms, %s\n",
+           plain.size(), packed.size(), encode_ms, decode_ms, object == config ? "passed" : "failed");
+}
+
+void view_example()
+{
+    std::map<std::string, std::string> config{};
+
+    for (uint32_t i = 0; i < 50000; ++i)
+        config.emplace("section_" + std::to_string(i % 100) + ".key_" + std::to_string(i), "enabled=true;timeout=30;retries=" + std::to_string(i % 5));
+
+    auto data = zpacker::serialize(config, zpacker::crc32c_checksum{});
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto copied = zpacker::deserialize<std::map<std::string, std::string>>(data, zpacker::crc32c_checksum{});
+
+    auto copy_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    // the keys and values point into `data`, which must outlive `viewed`
+    auto viewed = zpacker::deserialize<std::map<std::string_view, std::string_view>>(data, zpacker::crc32c_checksum{});
+
+    auto view_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto passed = viewed.size() == copied.size() && std::equal(viewed.begin(), viewed.end(), copied.begin(), [](const auto &l, const auto &r)
+                                                               { return l.first == r.first && l.second == r.second; });
+
+    printf("views: copy %.1f ms, zero-copy %.1f ms, %s\n", copy_ms, view_ms, passed ? "passed" : "failed");
+}
+
+void lazy_container_example()
+{
+    std::map<uint32_t, Row> rows{};
+
+    for (uint32_t i = 0; i < 1000000; ++i)
+        rows.emplace(i * 3, Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    // write the map with an offset table in front of its elements
+    auto data = zpacker::serialize(zpacker::indexed(rows), zpacker::crc32c_checksum{});
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto object = zpacker::deserialize<std::map<uint32_t, Row>>(data, zpacker::crc32c_checksum{});
+
+    auto eager_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    // only the keys visited by the binary search and the element found are decoded
+    auto lazy = zpacker::deserialize<zpacker::lazy_container<std::map<uint32_t, Row>>>(data, zpacker::crc32c_checksum{});
+
+    auto index = lazy.find(300000);
+
+    auto row = lazy[index];
+
+    auto lazy_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("lazy: %zd elements, deserialize all %.1f ms, find one %.3f ms (checksum included), %s\n", lazy.size(), eager_ms, lazy_ms,
+           object.size() == rows.size() && row.first == 300000 && row.second.data == rows[300000].data ? "passed" : "failed");
+}
+
+void mapped_file_example()
+{
+    std::map<uint32_t, Row> rows{};
+
+    for (uint32_t i = 0; i < 1000000; ++i)
+        rows.emplace(i, Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    // the package is written straight into the mapped file, no intermediate buffer
+    auto written = zpacker::serialize_file("mapped.bin", zpacker::indexed(rows), zpacker::crc32c_checksum{});
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto object = zpacker::deserialize_file<std::map<uint32_t, Row>>("mapped.bin", zpacker::crc32c_checksum{});
+
+    auto load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    // only the pages touched by the lookup are read from the file
+    zpacker::mapped_file_reader reader{"mapped.bin", zpacker::map_access::random};
+
+    reader.skip(sizeof(zpacker::packer_header));
+
+    auto lazy = reader.read<zpacker::lazy_container<std::map<uint32_t, Row>>>();
+
+    auto row = lazy[lazy.find(123456)];
+
+    auto lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("mapped file: %zd bytes, load all %.1f ms, open and look up one %.3f ms, %s\n", reader.size(), load_ms, lookup_ms,
+           written && object.size() == rows.size() && row.second.data == rows[123456].data ? "passed" : "failed");
+
+    reader.close();
+
+    std::remove("mapped.bin");
+}
+
+void message_frames_example()
+{
+    std::vector<uint8_t> sent{};
+
+    for (uint32_t i = 0; i < 1000; ++i)
+        zpacker::serialize_append(sent, std::vector<std::string>(i % 10, std::to_string(i)), zpacker::crc32c_checksum{});
+
+    std::vector<uint8_t> received{};
+    std::vector<std::vector<std::string>> messages{};
+
+    // the bytes arrive in pieces that do not line up with the messages, a truncated one is completed by the next piece
+    for (size_t offset = 0; offset < sent.size(); offset += 1000)
+    {
+        received.insert(received.end(), sent.begin() + offset, sent.begin() + (std::min)(offset + 1000, sent.size()));
+
+        zpacker::message_frames<zpacker::crc32c_checksum> frames{received};
+
+        for (auto frame : frames)
+            messages.push_back(frame.get<std::vector<std::string>>(zpacker::crc32c_checksum{}));
+
+        received.erase(received.begin(), received.begin() + frames.consumed());
+    }
+
+    printf("message frames: %zd messages in %zd bytes, %s\n", messages.size(), sent.size(),
+           messages.size() == 1000 && received.empty() && messages[999] == std::vector<std::string>(9, "999") ? "passed" : "failed");
+}
+
+void batch_example()
+{
+    std::vector<Row> records{};
+
+    for (uint32_t i = 0; i < 10000; ++i)
+        records.push_back(Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    size_t single_bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // one package per record, each with its own buffer, packer header and checksum
+    for (auto &record : records)
+        single_bytes += zpacker::serialize(record, zpacker::crc32c_checksum{}).size();
+
+    auto single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / records.size();
+
+    start = std::chrono::steady_clock::now();
+
+    auto data = zpacker::serialize_many(records, zpacker::crc32c_checksum{});
+
+    auto batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / records.size();
+
+    std::vector<Row> object{};
+
+    auto count = zpacker::deserialize_many<Row>(data, std::back_inserter(object), zpacker::crc32c_checksum{});
+
+    printf("batch: %zd records, one package each %.1f bytes %.0f ns, serialize_many %.1f bytes %.0f ns per record, %s\n", records.size(),
+           static_cast<double>(single_bytes) / records.size(), single_ns, static_cast<double>(data.size()) / records.size(), batch_ns,
+           count == records.size() && object[9999].data == records[9999].data ? "passed" : "failed");
+}
+
+void parallel_example()
+{
+    std::vector<Row> rows{};
+
+    for (uint32_t i = 0; i < 2000000; ++i)
+        rows.push_back(Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto serial = zpacker::serialize(rows, zpacker::crc32c_checksum{});
+
+    auto serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    // one thread per core
+    auto parallel = zpacker::serialize_parallel(rows, zpacker::crc32c_checksum{});
+
+    auto parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("parallel: %zd bytes on %u cores, serial %.1f ms, parallel %.1f ms, %s\n", parallel.size(), std::thread::hardware_concurrency(),
+           serial_ms, parallel_ms, serial == parallel ? "passed" : "failed");
+
+    // the offset table of indexed tells every thread where its slice of the elements starts
+    auto data = zpacker::serialize(zpacker::indexed(rows), zpacker::crc32c_checksum{});
+
+    start = std::chrono::steady_clock::now();
+
+    auto object = zpacker::deserialize<std::vector<Row>>(data, zpacker::crc32c_checksum{});
+
+    serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    auto parallel_object = zpacker::deserialize_parallel<std::vector<Row>>(data, zpacker::crc32c_checksum{});
+
+    parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("parallel: deserialize serial %.1f ms, parallel %.1f ms, %s\n", serial_ms, parallel_ms,
+           object.size() == rows.size() && parallel_object.size() == rows.size() && parallel_object[1999999].data == rows[1999999].data ? "passed" : "failed");
+
+    start = std::chrono::steady_clock::now();
+
+    auto crc = zpacker::crc32c_checksum{}(data.data(), data.size());
+
+    serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    // the crcs of the blocks are merged by crc32c_checksum::combine()
+    auto parallel_crc = zpacker::parallel_checksum(zpacker::crc32c_checksum{}, data.data(), data.size());
+
+    parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("parallel: checksum serial %.2f ms, parallel %.2f ms, %s\n", serial_ms, parallel_ms, crc == parallel_crc ? "passed" : "failed");
+
+    std::vector<TaggedRow> tagged{};
+
+    for (uint32_t i = 0; i < 70000; ++i)
+        tagged.push_back(TaggedRow{i, "row " + std::to_string(i)});
+
+    // the chunks overrun their slots, so the container is serialized again on the calling thread
+    auto tagged_parallel = zpacker::serialize_parallel(tagged, zpacker::crc32c_checksum{}, zpacker::empty_encoder{}, 4);
+
+    auto tagged_object = zpacker::deserialize<std::vector<TaggedRow>>(tagged_parallel, zpacker::crc32c_checksum{});
+
+    printf("parallel: get_size too small, %zd bytes, %s\n", tagged_parallel.size(),
+           tagged_parallel == zpacker::serialize(tagged, zpacker::crc32c_checksum{}) && tagged_object.size() == tagged.size() &&
+                   tagged_object[69999].tag == tagged[69999].tag
+               ? "passed"
+               : "failed");
+}
+
 void test_multi_map()
 {
     std::unordered_multimap<std::string, int> multimap1{{"Jacky", 64}, {"Jacky", 32}};
@@ -328,6 +723,231 @@ void stream_example()
     os.close();
 }
 
+void stream_writer_example()
+{
+    std::map<uint32_t, Row> rows{};
+
+    for (uint32_t i = 0; i < 1000000; ++i)
+        rows.emplace(i, Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    bool written = false;
+
+    {
+        std::ofstream os{"stream.bin", std::ios::binary};
+
+        // only 4KB are buffered, the checksum is patched into the packer header by seeking back once the payload is done
+        zpacker::stream_writer writer{os, 4096};
+
+        written = zpacker::serialize_stream(writer, rows, zpacker::crc32c_checksum{});
+    }
+
+    std::ifstream is{"stream.bin", std::ios::binary};
+
+    // read back through a 4KB window as well, the file is never loaded as a whole
+    zpacker::stream_reader reader{is, 4096};
+
+    auto object = zpacker::deserialize_stream<std::map<uint32_t, Row>>(reader, zpacker::crc32c_checksum{});
+
+    printf("stream writer/reader: %zd bytes, %s\n", reader.count(),
+           written && object.size() == rows.size() && object[123456].data == rows[123456].data ? "passed" : "failed");
+
+    is.close();
+
+    std::remove("stream.bin");
+}
+
+void compact_example()
+{
+    std::vector<Row> rows{};
+
+    for (uint32_t i = 0; i < 500000; ++i)
+        rows.push_back(Row{static_cast<uint16_t>(i), {1, 2, static_cast<int>(i)}});
+
+    // small signed deltas, zigzag keeps the negative ones short too
+    std::vector<int64_t> deltas{};
+
+    for (int64_t i = 0; i < 2000000; ++i)
+        deltas.push_back((i * 7919) % 2001 - 1000);
+
+    // every pair has a data_header of its own, a single byte in compact mode
+    std::map<std::string, int> pairs{};
+
+    for (int i = 0; i < 200000; ++i)
+        pairs.emplace("key" + std::to_string(i), i % 100);
+
+    auto measure = [](const char *name, const auto &value)
+    {
+        using value_type = std::decay_t<decltype(value)>;
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto fixed = zpacker::serialize(value);
+
+        auto fixed_write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+
+        auto fixed_object = zpacker::deserialize<value_type>(fixed);
+
+        auto fixed_read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+
+        auto compact = zpacker::serialize(zpacker::compact, value);
+
+        auto compact_write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+
+        auto compact_object = zpacker::deserialize<value_type>(zpacker::compact, compact);
+
+        auto compact_read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        printf("compact: %s, fixed %zd bytes, write %.1f ms, read %.1f ms; compact %zd bytes, write %.1f ms, read %.1f ms, %s\n", name,
+               fixed.size(), fixed_write_ms, fixed_read_ms, compact.size(), compact_write_ms, compact_read_ms,
+               zpacker::serialize(fixed_object) == fixed && zpacker::serialize(compact_object) == fixed ? "passed" : "failed");
+    };
+
+    measure("rows", rows);
+    measure("deltas", deltas);
+    measure("pairs", pairs);
+}
+
+void delta_example()
+{
+    // ids close to each other, as in an id set or the keys of an index
+    std::set<uint32_t> ids{};
+
+    for (uint32_t i = 0; ids.size() < 1000000; ++i)
+        ids.insert(i * 7 + i % 5);
+
+    // sorted timestamps in microseconds, a few milliseconds apart
+    std::vector<int64_t> timestamps{};
+
+    for (int64_t i = 0; i < 5000000; ++i)
+        timestamps.push_back(1700000000000000 + i * 2500 + (i * 7919) % 1000);
+
+    auto measure = [](const char *name, const auto &value)
+    {
+        using value_type = std::decay_t<decltype(value)>;
+
+        auto fixed = zpacker::serialize(value);
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto delta = zpacker::serialize(zpacker::delta_encoded(value));
+
+        auto write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+
+        // no wrapper to read, the container is rebuilt from the deltas
+        auto object = zpacker::deserialize<value_type>(delta);
+
+        auto read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        printf("delta: %s, fixed %zd bytes, delta %zd bytes, write %.1f ms, read %.1f ms, %s\n", name, fixed.size(), delta.size(),
+               write_ms, read_ms, object == value ? "passed" : "failed");
+    };
+
+    measure("ids", ids);
+    measure("timestamps", timestamps);
+}
+
+void columnar_example()
+{
+    // the price of an instrument by its id, ids and prices only change a little from one to the next
+    std::map<uint32_t, double> prices{};
+
+    for (uint32_t i = 0; i < 1000000; ++i)
+        prices.emplace(100000 + i * 4, 100.0 + (i % 2000) * 0.25);
+
+    auto measure = [&prices](const char *name, const auto &value)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        auto data = zpacker::serialize(value);
+
+        auto write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+
+        auto object = zpacker::deserialize<std::map<uint32_t, double>>(data);
+
+        auto read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        auto packed = zpacker::serialize(value, zpacker::empty_checksum{}, zpacker::lz4_encoder{});
+
+        printf("columnar: %s, %zd bytes, lz4 %zd bytes, write %.1f ms, read %.1f ms, %s\n", name, data.size(), packed.size(),
+               write_ms, read_ms, object == prices ? "passed" : "failed");
+    };
+
+    measure("interleaved", prices);
+    measure("columns", zpacker::columnar(prices));
+}
+
+void large_object_example()
+{
+    // 16 bytes past 4 GiB, both the string length and the package length need 64 bits
+    std::string text(0x100000010ull, 'z');
+
+    text.back() = 'a';
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto written = zpacker::serialize_file("large.bin", text, zpacker::crc32c_checksum{});
+
+    auto write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // three slices of the string, the offset of the last one is past 4 GiB so the index has 64-bit offsets
+    std::vector<std::string_view> slices{std::string_view{text}.substr(0, 0x80000000ull),
+                                         std::string_view{text}.substr(0x80000000ull, 0x80000000ull),
+                                         std::string_view{text}.substr(0x100000000ull)};
+
+    auto indexed_written = zpacker::serialize_file("large_indexed.bin", zpacker::indexed(slices), zpacker::crc32c_checksum{});
+
+    auto length = text.size();
+
+    std::string{}.swap(text);
+
+    start = std::chrono::steady_clock::now();
+
+    // read back as a view over the mapping, the payload is not copied again
+    zpacker::mapped_file_reader reader{"large.bin"};
+
+    auto view = zpacker::deserialize<std::string_view>(reader.data(), reader.size(), zpacker::crc32c_checksum{});
+
+    auto read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("large object: %zd bytes, write %.1f ms, read %.1f ms, %s\n", reader.size(), write_ms, read_ms,
+           written && view.size() == length && view.front() == 'z' && view.back() == 'a' ? "passed" : "failed");
+
+    reader.close();
+
+    std::remove("large.bin");
+
+    zpacker::mapped_file_reader indexed_reader{"large_indexed.bin", zpacker::map_access::random};
+
+    auto all = zpacker::deserialize<std::vector<std::string_view>>(indexed_reader.data(), indexed_reader.size(), zpacker::crc32c_checksum{});
+
+    // a payload of 4 GiB or more has the wider packer header
+    indexed_reader.skip(sizeof(zpacker::packer_header_large));
+
+    auto lazy = indexed_reader.read<zpacker::lazy_container<std::vector<std::string_view>>>();
+
+    auto last = lazy[2];
+
+    printf("large indexed: %zd bytes, %s\n", indexed_reader.size(),
+           indexed_written && all.size() == 3 && all[1].size() == 0x80000000ull && all[2] == "zzzzzzzzzzzzzzza" &&
+                   lazy.size() == 3 && lazy[1].size() == 0x80000000ull && last == "zzzzzzzzzzzzzzza"
+               ? "passed"
+               : "failed");
+
+    indexed_reader.close();
+
+    std::remove("large_indexed.bin");
+}
+
 int main(int argc, char const *argv[])
 {
     array_example();
@@ -337,6 +957,7 @@ int main(int argc, char const *argv[])
     variant_example();
     tuple_example();
     get_size_example();
+    exact_size_example();
 
     sequence_container_example();
     association_container_example();
@@ -344,6 +965,24 @@ int main(int argc, char const *argv[])
     test_multi_map();
 
     stream_example();
+    stream_writer_example();
+
+    reserve_benchmark();
+
+    compression_example();
+    view_example();
+    lazy_container_example();
+    mapped_file_example();
+    message_frames_example();
+    batch_example();
+    parallel_example();
+    compact_example();
+    delta_example();
+    columnar_example();
+
+    // needs more than 4 GiB of memory and disk, run with --large
+    if (argc > 1 && std::string{argv[1]} == "--large")
+        large_object_example();
 
     return 0;
 }
@@ -1,12 +1,35 @@
 #pragma once
 
+/* lets the add-on headers (zpacker_mmap.hpp, ...) know which language level is in use */
+#define ZPACKER_HPP
+
 #include <array>
 #include <tuple>
 #include <iterator>
 #include <algorithm>
 #include <variant>
 #include <vector>
+#include <string_view>
 #include <numeric>
+#include <limits>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define ZPACKER_X86_64
+#endif
+
+/* define ZPACKER_NO_SIMD where vector registers are not available, e.g. kernel mode */
+#if defined(ZPACKER_X86_64) && !defined(ZPACKER_NO_SIMD)
+#define ZPACKER_SIMD
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ZPACKER_TARGET(features)
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define ZPACKER_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
 
 namespace zpacker
 {
@@ -14,7 +37,7 @@ namespace zpacker
     inline constexpr bool Always_false = false;
 
     constexpr std::uint16_t VERSION_MAJOR = 0x0;
-    constexpr std::uint16_t VERSION_MINOR = 0x1;
+    constexpr std::uint16_t VERSION_MINOR = 0x2;
 
     constexpr std::uint16_t make_version(std::uint16_t major, std::uint16_t minor)
     {
@@ -23,6 +46,9 @@ namespace zpacker
 
     constexpr std::uint16_t VERSION = make_version(VERSION_MAJOR, VERSION_MINOR);
 
+    /* previous package version, it is still accepted by deserialize */
+    constexpr std::uint16_t VERSION_1 = make_version(0x0, 0x1);
+
     /* check if a type is a specialization of a template with single type and extract the single type of template */
     template <typename _Type, template <class...> typename _Template>
     struct is_specialize_of : std::false_type
@@ -117,6 +143,20 @@ namespace zpacker
         template <class _Ty>
         std::false_type has_reserve_impl(...);
 
+        template <class _Ty>
+        auto has_resize_impl(int) -> decltype(std::declval<_Ty>().resize(0), std::true_type{});
+
+        template <class _Ty>
+        std::false_type has_resize_impl(...);
+
+        template <class _Ty>
+        auto has_buffer_impl(int) -> std::enable_if_t<
+            std::is_convertible_v<decltype(std::declval<const _Ty &>().data()), const uint8_t *>,
+            std::true_type>;
+
+        template <class _Ty>
+        std::false_type has_buffer_impl(...);
+
         template <class _Ty>
         auto has_serialize1_impl(int) -> decltype(std::declval<_Ty>().serialize(std::declval<std::add_lvalue_reference_t<bytes_writer>>()), std::true_type{});
 
@@ -153,6 +193,14 @@ namespace zpacker
         template <class _Ty>
         std::false_type has_value_type_impl(...);
 
+        template <class _Ty>
+        auto is_contiguous_container_impl(int) -> std::enable_if_t<
+            std::is_same_v<decltype(std::declval<const _Ty &>().data()), const typename _Ty::value_type *>,
+            decltype(std::declval<const _Ty &>().size(), std::true_type{})>;
+
+        template <class _Ty>
+        std::false_type is_contiguous_container_impl(...);
+
         template <class _Ty, class _Vty>
         auto is_reader_impl(int) -> decltype(std::declval<_Ty>().template can_read<int>(),
                                              std::declval<_Ty>().template read<_Vty>(),
@@ -224,6 +272,19 @@ namespace zpacker
     template <class _Ty>
     constexpr bool has_reserve_v = has_reserve<_Ty>::value;
 
+    template <class _Ty>
+    using has_resize = decltype(detail::has_resize_impl<_Ty>(0));
+
+    template <class _Ty>
+    constexpr bool has_resize_v = has_resize<_Ty>::value;
+
+    /* readers and writers that expose their underlying byte buffer by data() */
+    template <class _Ty>
+    using has_buffer = decltype(detail::has_buffer_impl<_Ty>(0));
+
+    template <class _Ty>
+    constexpr bool has_buffer_v = has_buffer<_Ty>::value;
+
     template <class _Ty>
     using has_serialize_unbounded = decltype(detail::has_serialize1_impl<_Ty>(0));
 
@@ -299,6 +360,149 @@ namespace zpacker
     template <class _Ty>
     constexpr bool is_associated_container_v = is_associated_container<_Ty>::value;
 
+    /* std::vector, std::basic_string, std::array, etc. whose elements are stored in one block */
+    template <class _Ty>
+    using is_contiguous_container = decltype(detail::is_contiguous_container_impl<std::remove_cv_t<_Ty>>(0));
+
+    template <class _Ty>
+    constexpr bool is_contiguous_container_v = is_contiguous_container<_Ty>::value;
+
+    /*
+     * Non-owning view over contiguous elements, the counterpart of std::span before C++20
+     */
+    template <class _Ty>
+    class span
+    {
+    public:
+        using element_type = _Ty;
+        using value_type = std::remove_cv_t<_Ty>;
+        using size_type = size_t;
+        using pointer = _Ty *;
+        using reference = _Ty &;
+        using iterator = _Ty *;
+        using const_iterator = const _Ty *;
+
+        constexpr span() noexcept = default;
+
+        constexpr span(_Ty *data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+        template <class _Container, std::enable_if_t<std::is_convertible_v<decltype(std::declval<_Container &>().data()), _Ty *>, int> = 0>
+        constexpr span(_Container &container) noexcept : m_data(container.data()), m_size(container.size()) {}
+
+        constexpr _Ty *data() const noexcept
+        {
+            return m_data;
+        }
+
+        constexpr size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        constexpr size_t size_bytes() const noexcept
+        {
+            return m_size * sizeof(_Ty);
+        }
+
+        constexpr bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        constexpr _Ty &operator[](size_t index) const
+        {
+            return m_data[index];
+        }
+
+        constexpr iterator begin() const noexcept
+        {
+            return m_data;
+        }
+
+        constexpr iterator end() const noexcept
+        {
+            return m_data + m_size;
+        }
+
+    private:
+        _Ty *m_data{nullptr};
+        size_t m_size{0};
+    };
+
+    /* std::basic_string_view and span, deserialized as views into the reader's buffer */
+    template <class _Ty>
+    struct is_view : std::false_type
+    {
+    };
+
+    template <class _Elem, class _Traits>
+    struct is_view<std::basic_string_view<_Elem, _Traits>> : std::true_type
+    {
+    };
+
+    template <class _Ty>
+    struct is_view<span<_Ty>> : std::true_type
+    {
+    };
+
+    template <class _Ty>
+    constexpr bool is_view_v = is_view<std::remove_cv_t<std::remove_reference_t<_Ty>>>::value;
+
+    /*
+     * a view, or a pair/tuple with a view member such as the value type of std::map<std::string_view, ...>
+     * indexed, delta_encoded, columnar and lazy_container refer to memory they do not own either
+     */
+    template <class _Ty>
+    struct holds_view : is_view<_Ty>
+    {
+    };
+
+    template <class _Ty1, class _Ty2>
+    struct holds_view<std::pair<_Ty1, _Ty2>> : std::bool_constant<holds_view<std::remove_cv_t<_Ty1>>::value || holds_view<std::remove_cv_t<_Ty2>>::value>
+    {
+    };
+
+    template <class... _Types>
+    struct holds_view<std::tuple<_Types...>> : std::bool_constant<(holds_view<std::remove_cv_t<_Types>>::value || ...)>
+    {
+    };
+
+    template <class _Container>
+    class indexed;
+
+    template <class _Container>
+    class lazy_container;
+
+    template <class _Container>
+    class delta_encoded;
+
+    template <class _Container>
+    class columnar;
+
+    template <class _Container>
+    struct holds_view<indexed<_Container>> : std::true_type
+    {
+    };
+
+    template <class _Container>
+    struct holds_view<delta_encoded<_Container>> : std::true_type
+    {
+    };
+
+    template <class _Container>
+    struct holds_view<columnar<_Container>> : std::true_type
+    {
+    };
+
+    template <class _Container>
+    struct holds_view<lazy_container<_Container>> : std::true_type
+    {
+    };
+
+    /* values that are stored as their raw bytes, views are trivially copyable but stored like their containers */
+    template <class _Ty>
+    constexpr bool is_trivially_serializable_v = std::is_trivially_copyable_v<_Ty> && !holds_view<std::remove_cv_t<_Ty>>::value;
+
     template <class _Ty>
     using remove_cvref_t = std::remove_cv_t<std::remove_reference_t<_Ty>>;
 
@@ -315,6 +519,7 @@ namespace zpacker
 
         d_pod,
 
+        /* also the header of a container written by columnar, the container type follows it as a byte */
         d_pair,
 
         d_variant,
@@ -325,7 +530,13 @@ namespace zpacker
 
         d_aso_container,
 
-        d_custom
+        d_custom,
+
+        /* a container preceded by an offset table of its elements, written by indexed */
+        d_indexed,
+
+        /* a container of integers stored as varint deltas, written by delta_encoded */
+        d_delta
     };
 
 #pragma warning(disable : 4702)
@@ -340,7 +551,7 @@ namespace zpacker
             return d_variant;
         else if constexpr (is_specialize_of_v<_Ty, std::tuple>)
             return d_tuple;
-        else if constexpr (is_sequence_container_v<_Ty>)
+        else if constexpr (is_sequence_container_v<_Ty> || is_view_v<_Ty>)
             return d_seq_container;
         else if constexpr (is_associated_container_v<_Ty>)
             return d_aso_container;
@@ -416,19 +627,72 @@ namespace zpacker
         }
     };
 
+    /*
+     * Algorithm that produced packer_header::crc
+     */
+    enum checksum_type : uint8_t
+    {
+        ct_none = 0,
+
+        ct_crc8,
+        ct_crc16,
+        ct_crc32,
+        ct_crc32c,
+        ct_xxh64,
+
+        /* checksum policy without a `type` member */
+        ct_custom = 0xff
+    };
+
+    /*
+     * Codec of the payload, recorded in the low bits of packer_header::flags
+     */
+    enum codec_type : uint8_t
+    {
+        cd_none = 0,
+
+        cd_lz4,
+
+        /* encoder policy without a `type` member */
+        cd_custom = 0x0f
+    };
+
+    constexpr uint8_t _codec_mask = 0x0f;
+
+    /* the payload was written by compact_writer */
+    constexpr uint8_t _flag_compact = 0x10;
+
+    /* the package has a packer_header_large, its payload is 4 GiB or more */
+    constexpr uint8_t _flag_large = 0x20;
+
+    /*
+     * data_header::length of a container with this many elements or more,
+     * the element count follows the data_header as a std::uint64_t
+     * The offset table of an indexed container with this length has 64-bit offsets
+     */
+    constexpr std::uint32_t _large_length = 0xffffffff;
+
     struct packer_header
     {
         std::uint16_t version;
 
+        /* checksum_type */
+        uint8_t checksum;
+
+        /* bits 0-3: codec_type of the payload, bit 4: _flag_compact, bit 5: _flag_large, the other bits are reserved and must be zero */
+        uint8_t flags;
+
+        /* length of the payload as stored, after encoding */
+        std::uint32_t length;
+
         union
         {
             uint8_t crc8;
             std::uint16_t crc16;
             std::uint32_t crc32;
+            std::uint64_t crc64;
         } crc;
 
-        std::uint32_t length;
-
         void set_version(std::uint16_t ver)
         {
             version = ver;
@@ -446,10 +710,117 @@ namespace zpacker
             version |= (std::uint16_t)minor;
         }
     };
+
+    /*
+     * Packer header of a payload of 4 GiB or more, written only when needed and flagged by _flag_large
+     * The layout is packer_header with a 64-bit length, the packer header of any version is read into it
+     */
+    struct packer_header_large
+    {
+        std::uint16_t version;
+
+        uint8_t checksum;
+
+        uint8_t flags;
+
+        std::uint64_t length;
+
+        union
+        {
+            uint8_t crc8;
+            std::uint16_t crc16;
+            std::uint32_t crc32;
+            std::uint64_t crc64;
+        } crc;
+    };
+
+    /* packer header layout of VERSION_1 */
+    struct packer_header_v1
+    {
+        std::uint16_t version;
+
+        union
+        {
+            uint8_t crc8;
+            std::uint16_t crc16;
+            std::uint32_t crc32;
+        } crc;
+
+        std::uint32_t length;
+    };
 #pragma pack(pop)
 
+    namespace detail
+    {
+        template <class _Ty>
+        auto checksum_type_impl(int) -> std::integral_constant<checksum_type, _Ty::type>;
+
+        template <class _Ty>
+        std::integral_constant<checksum_type, ct_custom> checksum_type_impl(...);
+    }
+
+    /* the checksum_type recorded for a checksum policy */
+    template <class _CheckSum>
+    constexpr checksum_type checksum_type_v = decltype(detail::checksum_type_impl<_CheckSum>(0))::value;
+
+    namespace detail
+    {
+        template <class _Ty>
+        auto has_streaming_checksum_impl(int) -> decltype(
+            std::declval<const _Ty &>().init(),
+            std::declval<const _Ty &>().update(std::declval<typename _Ty::state_type &>(), std::declval<const uint8_t *>(), size_t{}),
+            std::declval<const _Ty &>().finalize(std::declval<const typename _Ty::state_type &>()),
+            std::true_type{});
+
+        template <class _Ty>
+        std::false_type has_streaming_checksum_impl(...);
+    }
+
+    /*
+     * Checksum policies exposing init()/update()/finalize() can be computed incrementally,
+     * serialize() and deserialize() then update them while the payload is written or parsed
+     */
+    template <class _CheckSum>
+    constexpr bool has_streaming_checksum_v = decltype(detail::has_streaming_checksum_impl<_CheckSum>(0))::value;
+
+    namespace detail
+    {
+        template <class _Ty>
+        auto has_checksum_combine_impl(int) -> decltype(
+            std::declval<const _Ty &>().combine(std::declval<const _Ty &>()(nullptr, 0), std::declval<const _Ty &>()(nullptr, 0), size_t{}),
+            std::true_type{});
+
+        template <class _Ty>
+        std::false_type has_checksum_combine_impl(...);
+    }
+
+    /*
+     * Checksum policies exposing combine() merge the checksums of adjacent blocks,
+     * so the blocks of a payload can be checked on several threads
+     */
+    template <class _CheckSum>
+    constexpr bool has_checksum_combine_v = decltype(detail::has_checksum_combine_impl<_CheckSum>(0))::value;
+
     struct empty_checksum
     {
+        static constexpr checksum_type type = ct_none;
+
+        using state_type = uint8_t;
+
+        state_type init() const
+        {
+            return 0;
+        }
+
+        void update(state_type &, const uint8_t *, size_t) const
+        {
+        }
+
+        std::uint32_t finalize(const state_type &) const
+        {
+            return 0;
+        }
+
         std::uint32_t operator()(const uint8_t *data, size_t length) const
         {
             (void *)data;
@@ -531,842 +902,4721 @@ namespace zpacker
 
     static constexpr std::array<std::uint32_t, 256> CRC32_TABLE = generate_crc32_table();
 
-    struct crc8_checksum
+    namespace detail
     {
-        uint8_t operator()(const uint8_t *data, size_t length) const
+        /*
+         * Slice tables for processing several bytes per step, slices[k][b] is the crc of byte b followed by k zero bytes
+         */
+        template <class _Ty, size_t _Slices, bool _Reflected>
+        constexpr auto generate_crc_slices(const std::array<_Ty, 256> &table)
         {
-            uint8_t crc = 0x0;
+            constexpr unsigned _Shift = sizeof(_Ty) * 8 - 8;
 
-            for (size_t i = 0; i < length; ++i)
-                crc = CRC8_TABLE[crc ^ data[i]];
+            std::array<std::array<_Ty, 256>, _Slices> slices = {};
 
-            return crc;
+            slices[0] = table;
+
+            for (size_t k = 1; k < _Slices; ++k)
+            {
+                for (size_t i = 0; i < 256; ++i)
+                {
+                    auto prev = slices[k - 1][i];
+
+                    if constexpr (_Reflected)
+                        slices[k][i] = static_cast<_Ty>((prev >> 8) ^ table[prev & 0xff]);
+                    else
+                        slices[k][i] = static_cast<_Ty>((prev << 8) ^ table[(prev >> _Shift) & 0xff]);
+                }
+            }
+
+            return slices;
         }
-    };
 
-    struct crc16_checksum
-    {
-        std::uint16_t operator()(const uint8_t *data, size_t length) const
+        constexpr std::uint64_t reflect64(std::uint64_t value)
         {
-            std::uint16_t crc = 0xFFFF;
+            std::uint64_t result = 0;
 
-            for (size_t i = 0; i < length; ++i)
-                crc = (crc << 8) ^ CRC16_TABLE[(crc >> 8) ^ data[i]];
+            for (int i = 0; i < 64; ++i)
+                result |= ((value >> i) & 1) << (63 - i);
 
-            return crc;
+            return result;
         }
-    };
+    }
 
-    struct crc32_checksum
+    static constexpr auto CRC8_SLICES = detail::generate_crc_slices<uint8_t, 8, false>(CRC8_TABLE);
+    static constexpr auto CRC16_SLICES = detail::generate_crc_slices<std::uint16_t, 8, false>(CRC16_TABLE);
+    static constexpr auto CRC32_SLICES = detail::generate_crc_slices<std::uint32_t, 16, true>(CRC32_TABLE);
+
+    /* _polynomial_crc32 in non-reflected form */
+    constexpr std::uint32_t _polynomial_crc32_normal = static_cast<std::uint32_t>(detail::reflect64(_polynomial_crc32) >> 32);
+
+    namespace detail
     {
-        std::uint32_t operator()(const uint8_t *data, size_t length) const
+#ifdef ZPACKER_SIMD
+        struct cpu_features
         {
-            std::uint32_t crc = 0xFFFFFFFF;
+            bool pclmul;
+            bool ssse3;
+            bool sse42;
+        };
 
-            for (size_t i = 0; i < length; ++i)
-                crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
+        inline cpu_features detect_cpu_features()
+        {
+            unsigned int ecx = 0;
 
-            return ~crc;
-        }
-    };
+#if defined(_MSC_VER) && !defined(__clang__)
+            int regs[4] = {};
 
-    constexpr size_t _default_reserve_size = 4096;
+            __cpuid(regs, 1);
 
-    struct empty_encoder
-    {
-        std::vector<uint8_t> operator()(const void *input, size_t length) const
+            ecx = static_cast<unsigned int>(regs[2]);
+#else
+            unsigned int eax = 0, ebx = 0, edx = 0;
+
+            __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+#endif
+            return cpu_features{(ecx & (1u << 1)) != 0, (ecx & (1u << 9)) != 0, (ecx & (1u << 20)) != 0};
+        }
+
+        inline const cpu_features &get_cpu_features()
         {
-            return std::vector<uint8_t>{(uint8_t *)input, (uint8_t *)input + length};
+            static const cpu_features features = detect_cpu_features();
+
+            return features;
         }
-    };
 
-    struct empty_decoder
-    {
-        std::vector<uint8_t> operator()(const void *input, size_t length) const
+        inline bool has_clmul()
         {
-            return std::vector<uint8_t>{(uint8_t *)input, (uint8_t *)input + length};
+            return get_cpu_features().pclmul && get_cpu_features().ssse3;
         }
-    };
 
-    // forward declaration
-    template <class _Ty, class _Writer>
-    void serialize_object(_Writer &, const _Ty &);
+        /* x^n mod P, P is given without its leading term */
+        constexpr std::uint64_t xpow_mod(size_t n, std::uint64_t poly, unsigned width)
+        {
+            std::uint64_t result = 1;
 
-    template <
-        class _Ty,
-        class _Reader,
-        class>
-    _Ty deserialize_object(_Reader &);
-
-    class bytes_reader
-    {
-    public:
-        bytes_reader(const std::vector<uint8_t> &data) : m_data(std::addressof(data)) {}
-
-        template <class _Vty>
-        _Vty read()
-        {
-            if constexpr (std::is_trivially_copyable_v<_Vty>)
+            for (size_t i = 0; i < n; ++i)
             {
-                if (!can_read<_Vty>())
-                    return _Vty{};
-
-                auto result = *reinterpret_cast<_Vty *>(const_cast<uint8_t *>(m_data->data()) + m_pos);
-
-                m_pos += sizeof(_Vty);
+                result <<= 1;
 
-                return result;
-            }
-            else
-            {
-                return deserialize_object<_Vty>(*this);
+                if ((result >> width) & 1)
+                    result ^= (std::uint64_t{1} << width) | poly;
             }
+
+            return result;
         }
 
-        template <class _Vty>
-        bytes_reader &operator>>(_Vty &val)
+        /*
+         * Multipliers of the high and low 64-bit lanes that move a 128-bit block `distance` bits forward modulo P
+         * The reflected form carries one extra factor x produced by the carry-less multiply of reflected operands
+         */
+        template <unsigned _Width, bool _Reflected, std::uint64_t _Poly>
+        constexpr std::array<std::uint64_t, 2> fold_constants(size_t distance)
         {
-            val = this->read<_Vty>();
-
-            return *this;
+            if constexpr (_Reflected)
+                return {reflect64(xpow_mod(distance - 1, _Poly, _Width)), reflect64(xpow_mod(distance + 63, _Poly, _Width))};
+            else
+                return {xpow_mod(distance + 64, _Poly, _Width), xpow_mod(distance, _Poly, _Width)};
         }
 
-        std::vector<uint8_t> read_bytes(size_t count)
+        template <bool _Reflected>
+        ZPACKER_TARGET("pclmul,ssse3")
+        inline __m128i clmul_load(const uint8_t *data)
         {
-            auto available = (std::min)(count, m_data->size() - count);
-
-            auto result = std::vector<uint8_t>{m_data->data() + m_pos, m_data->data() + m_pos + available};
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
 
-            m_pos += available;
+            /* a non-reflected crc consumes the first byte as the highest coefficients */
+            if constexpr (!_Reflected)
+                block = _mm_shuffle_epi8(block, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
 
-            return result;
+            return block;
         }
 
-        template <class _Vty, std::enable_if_t<std::is_trivially_constructible_v<_Vty>, int> = 0>
-        bool can_read() const
+        ZPACKER_TARGET("pclmul,ssse3")
+        inline __m128i clmul_fold(__m128i block, __m128i constants, __m128i next)
         {
-            return remaining() >= sizeof(_Vty);
-        }
+            auto high = _mm_clmulepi64_si128(block, constants, 0x11);
+            auto low = _mm_clmulepi64_si128(block, constants, 0x00);
 
-        size_t remaining() const
-        {
-            return m_data->size() - m_pos;
+            return _mm_xor_si128(_mm_xor_si128(high, low), next);
         }
 
         /*
-         * Return total bytes that has been read out for now
-         * It also represent current buffer read position
+         * Fold `length` bytes (a multiple of 16, at least 64) into 16 bytes with the same crc remainder
+         * `crc` is the register state before `data`, the crc of `folded` starting from a zero register
+         * is the register state after `data`
          */
-        size_t count() const
+        template <unsigned _Width, bool _Reflected, std::uint64_t _Poly>
+        ZPACKER_TARGET("pclmul,ssse3")
+        inline void crc_fold_clmul(const uint8_t *data, size_t length, std::uint32_t crc, uint8_t *folded)
         {
-            return m_pos;
+            constexpr auto _k512 = fold_constants<_Width, _Reflected, _Poly>(512);
+            constexpr auto _k128 = fold_constants<_Width, _Reflected, _Poly>(128);
+
+            auto x1 = clmul_load<_Reflected>(data);
+            auto x2 = clmul_load<_Reflected>(data + 16);
+            auto x3 = clmul_load<_Reflected>(data + 32);
+            auto x4 = clmul_load<_Reflected>(data + 48);
+
+            if constexpr (_Reflected)
+                x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+            else
+                x1 = _mm_xor_si128(x1, _mm_set_epi64x(static_cast<long long>(static_cast<std::uint64_t>(crc) << (64 - _Width)), 0));
+
+            data += 64;
+            length -= 64;
+
+            auto k512 = _mm_set_epi64x(static_cast<long long>(_k512[0]), static_cast<long long>(_k512[1]));
+
+            for (; length >= 64; data += 64, length -= 64)
+            {
+                x1 = clmul_fold(x1, k512, clmul_load<_Reflected>(data));
+                x2 = clmul_fold(x2, k512, clmul_load<_Reflected>(data + 16));
+                x3 = clmul_fold(x3, k512, clmul_load<_Reflected>(data + 32));
+                x4 = clmul_fold(x4, k512, clmul_load<_Reflected>(data + 48));
+            }
+
+            auto k128 = _mm_set_epi64x(static_cast<long long>(_k128[0]), static_cast<long long>(_k128[1]));
+
+            x1 = clmul_fold(x1, k128, x2);
+            x1 = clmul_fold(x1, k128, x3);
+            x1 = clmul_fold(x1, k128, x4);
+
+            for (; length >= 16; data += 16, length -= 16)
+                x1 = clmul_fold(x1, k128, clmul_load<_Reflected>(data));
+
+            if constexpr (!_Reflected)
+                x1 = _mm_shuffle_epi8(x1, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(folded), x1);
         }
+#endif
 
-        void skip(size_t count)
+        /* below this length the table engines are faster than folding */
+        constexpr size_t _clmul_threshold = 64;
+
+        inline uint8_t crc8_update_table(uint8_t crc, const uint8_t *data, size_t length)
         {
-            if (remaining() >= count)
-                m_pos += count;
+            for (; length >= 8; data += 8, length -= 8)
+            {
+                crc = static_cast<uint8_t>(CRC8_SLICES[7][crc ^ data[0]] ^ CRC8_SLICES[6][data[1]] ^
+                                           CRC8_SLICES[5][data[2]] ^ CRC8_SLICES[4][data[3]] ^
+                                           CRC8_SLICES[3][data[4]] ^ CRC8_SLICES[2][data[5]] ^
+                                           CRC8_SLICES[1][data[6]] ^ CRC8_SLICES[0][data[7]]);
+            }
+
+            for (size_t i = 0; i < length; ++i)
+                crc = CRC8_TABLE[crc ^ data[i]];
+
+            return crc;
         }
 
-        void seek(size_t pos)
+        inline std::uint16_t crc16_update_table(std::uint16_t crc, const uint8_t *data, size_t length)
         {
-            if (pos < m_data->size() - count())
-                m_pos = pos;
+            for (; length >= 8; data += 8, length -= 8)
+            {
+                crc = static_cast<std::uint16_t>(CRC16_SLICES[7][(crc >> 8) ^ data[0]] ^ CRC16_SLICES[6][(crc & 0xff) ^ data[1]] ^
+                                                 CRC16_SLICES[5][data[2]] ^ CRC16_SLICES[4][data[3]] ^
+                                                 CRC16_SLICES[3][data[4]] ^ CRC16_SLICES[2][data[5]] ^
+                                                 CRC16_SLICES[1][data[6]] ^ CRC16_SLICES[0][data[7]]);
+            }
+
+            for (size_t i = 0; i < length; ++i)
+                crc = static_cast<std::uint16_t>((crc << 8) ^ CRC16_TABLE[(crc >> 8) ^ data[i]]);
+
+            return crc;
         }
 
-        void reset(const std::vector<uint8_t> *data)
+        inline std::uint32_t crc32_update_table(std::uint32_t crc, const uint8_t *data, size_t length)
         {
-            m_pos = 0;
-            m_data = data;
-        }
+            for (; length >= 16; data += 16, length -= 16)
+            {
+                crc ^= static_cast<std::uint32_t>(data[0]) | static_cast<std::uint32_t>(data[1]) << 8 |
+                       static_cast<std::uint32_t>(data[2]) << 16 | static_cast<std::uint32_t>(data[3]) << 24;
+
+                crc = CRC32_SLICES[15][crc & 0xff] ^ CRC32_SLICES[14][(crc >> 8) & 0xff] ^
+                      CRC32_SLICES[13][(crc >> 16) & 0xff] ^ CRC32_SLICES[12][crc >> 24] ^
+                      CRC32_SLICES[11][data[4]] ^ CRC32_SLICES[10][data[5]] ^
+                      CRC32_SLICES[9][data[6]] ^ CRC32_SLICES[8][data[7]] ^
+                      CRC32_SLICES[7][data[8]] ^ CRC32_SLICES[6][data[9]] ^
+                      CRC32_SLICES[5][data[10]] ^ CRC32_SLICES[4][data[11]] ^
+                      CRC32_SLICES[3][data[12]] ^ CRC32_SLICES[2][data[13]] ^
+                      CRC32_SLICES[1][data[14]] ^ CRC32_SLICES[0][data[15]];
+            }
 
-    private:
-        size_t m_pos{0};
-        const std::vector<uint8_t> *m_data;
-    };
+            for (size_t i = 0; i < length; ++i)
+                crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
 
-    class bytes_reader_bounded
-    {
-    public:
-        bytes_reader_bounded(const uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+            return crc;
+        }
 
-        template <class _Vty>
-        _Vty read()
+        /*
+         * Advance a crc register over `data`, picking the fastest engine the cpu supports
+         */
+        inline uint8_t crc8_update(uint8_t crc, const uint8_t *data, size_t length)
         {
-            if constexpr (std::is_trivially_copyable_v<_Vty>)
+#ifdef ZPACKER_SIMD
+            if (length >= _clmul_threshold && has_clmul())
             {
-                static_assert(std::is_default_constructible_v<_Vty>, "_Vty must be default constructible");
-
-                if (!can_read<_Vty>())
-                    return _Vty{};
+                uint8_t folded[16];
+                size_t blocks = length & ~static_cast<size_t>(15);
 
-                auto result = *reinterpret_cast<const _Vty *>(m_data + m_pos);
+                crc_fold_clmul<8, false, polynomial_crc8>(data, blocks, crc, folded);
 
-                m_pos += sizeof(_Vty);
+                crc = crc8_update_table(0, folded, sizeof(folded));
 
-                return result;
-            }
-            else
-            {
-                return deserialize_object<_Vty>(*this);
+                data += blocks;
+                length -= blocks;
             }
+#endif
+            return crc8_update_table(crc, data, length);
         }
 
-        template <class _Vty>
-        bytes_reader_bounded &operator>>(_Vty &val)
+        inline std::uint16_t crc16_update(std::uint16_t crc, const uint8_t *data, size_t length)
         {
-            val = this->read<_Vty>();
+#ifdef ZPACKER_SIMD
+            if (length >= _clmul_threshold && has_clmul())
+            {
+                uint8_t folded[16];
+                size_t blocks = length & ~static_cast<size_t>(15);
 
-            return *this;
+                crc_fold_clmul<16, false, polynomial_crc16>(data, blocks, crc, folded);
+
+                crc = crc16_update_table(0, folded, sizeof(folded));
+
+                data += blocks;
+                length -= blocks;
+            }
+#endif
+            return crc16_update_table(crc, data, length);
         }
 
-        std::vector<uint8_t> read_bytes(size_t count)
+        inline std::uint32_t crc32_update(std::uint32_t crc, const uint8_t *data, size_t length)
         {
-            auto available = (std::min)(count, m_length - count);
+#ifdef ZPACKER_SIMD
+            if (length >= _clmul_threshold && has_clmul())
+            {
+                uint8_t folded[16];
+                size_t blocks = length & ~static_cast<size_t>(15);
 
-            auto result = std::vector<uint8_t>{m_data + m_pos, m_data + m_pos + available};
+                crc_fold_clmul<32, true, _polynomial_crc32_normal>(data, blocks, crc, folded);
 
-            m_pos += available;
+                crc = crc32_update_table(0, folded, sizeof(folded));
 
-            return result;
+                data += blocks;
+                length -= blocks;
+            }
+#endif
+            return crc32_update_table(crc, data, length);
         }
+    }
 
-        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
-        bool can_read() const
-        {
-            return remaining() >= sizeof(_Vty);
-        }
+    struct crc8_checksum
+    {
+        static constexpr checksum_type type = ct_crc8;
 
-        size_t remaining() const
-        {
-            return m_length - m_pos;
-        }
+        using state_type = uint8_t;
 
-        void skip(size_t count)
+        state_type init() const
         {
-            if (remaining() >= count)
-                m_pos += count;
+            return 0x0;
         }
 
-        size_t count() const
+        void update(state_type &state, const uint8_t *data, size_t length) const
         {
-            return m_pos;
+            state = detail::crc8_update(state, data, length);
         }
 
-        void seek(size_t pos)
+        uint8_t finalize(const state_type &state) const
         {
-            if (pos < m_length - count())
-                m_pos = pos;
+            return state;
         }
 
-        void reset(const uint8_t *data, size_t length)
+        uint8_t operator()(const uint8_t *data, size_t length) const
         {
-            m_pos = 0;
-            m_data = data;
-            m_length = length;
+            return detail::crc8_update(0x0, data, length);
         }
-
-    private:
-        size_t m_pos{0};
-        const uint8_t *m_data{nullptr};
-        size_t m_length{0};
     };
 
-    class bytes_writer
+    struct crc16_checksum
     {
-    public:
-        bytes_writer(std::vector<uint8_t> &data) : m_data(std::addressof(data)) {}
+        static constexpr checksum_type type = ct_crc16;
 
-        template <class _Vty>
-        void write(const _Vty &val)
+        using state_type = std::uint16_t;
+
+        state_type init() const
         {
-            if constexpr (std::is_trivially_copyable_v<_Vty>)
-            {
-                auto begin = (uint8_t *)std::addressof(val);
+            return 0xFFFF;
+        }
 
-                m_data->insert(m_data->end(), begin, begin + sizeof(_Vty));
-            }
-            else
-            {
-                serialize_object(*this, val);
-            }
+        void update(state_type &state, const uint8_t *data, size_t length) const
+        {
+            state = detail::crc16_update(state, data, length);
         }
 
-        void write(const std::vector<uint8_t> &data)
+        std::uint16_t finalize(const state_type &state) const
         {
-            std::copy(data.begin(), data.end(), std::back_inserter(*m_data));
+            return state;
         }
 
-        void write(const uint8_t *data, size_t length)
+        std::uint16_t operator()(const uint8_t *data, size_t length) const
         {
-            std::copy(data, data + length, std::back_inserter(*m_data));
+            return detail::crc16_update(0xFFFF, data, length);
         }
+    };
 
-        template <class _Vty>
-        bytes_writer &operator<<(const _Vty &val)
+    namespace detail
+    {
+        inline std::uint32_t crc32_combine(std::uint32_t crc1, std::uint32_t crc2, size_t length2);
+    }
+
+    struct crc32_checksum
+    {
+        static constexpr checksum_type type = ct_crc32;
+
+        using state_type = std::uint32_t;
+
+        state_type init() const
         {
-            this->write(val);
+            return 0xFFFFFFFF;
+        }
 
-            return *this;
+        void update(state_type &state, const uint8_t *data, size_t length) const
+        {
+            state = detail::crc32_update(state, data, length);
         }
 
-        void reset(std::vector<uint8_t> &data)
+        std::uint32_t finalize(const state_type &state) const
         {
-            m_data = std::addressof(data);
+            return ~state;
         }
 
-        template <class _Ty>
-        constexpr bool can_write() const
+        std::uint32_t operator()(const uint8_t *data, size_t length) const
         {
-            return true;
+            return ~detail::crc32_update(0xFFFFFFFF, data, length);
         }
 
         /*
-         * Get the total bytes written
+         * Checksum of two adjacent blocks from the checksums of both, `length` is the size of the second block
          */
-        size_t count() const
+        std::uint32_t combine(std::uint32_t first, std::uint32_t second, size_t length) const
         {
-            return m_data->size();
+            return detail::crc32_combine(first, second, length);
         }
-
-    private:
-        std::vector<uint8_t> *m_data;
     };
 
-    class bytes_writer_bounded
+    constexpr std::uint32_t _polynomial_crc32c = 0x82F63B78;
+
+    constexpr std::uint32_t entry_crc32c(std::uint32_t i)
     {
-    public:
-        bytes_writer_bounded(uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+        std::uint32_t crc = i;
 
-        template <class _Vty>
-        void write(const _Vty &val)
+        for (int j = 0; j < 8; ++j)
+            crc = (crc & 1) ? (crc >> 1) ^ _polynomial_crc32c : (crc >> 1);
+
+        return crc;
+    }
+
+    constexpr auto generate_crc32c_table()
+    {
+        std::array<std::uint32_t, 256> table = {};
+
+        for (size_t i = 0; i < table.size(); ++i)
+            table[i] = entry_crc32c(static_cast<std::uint32_t>(i));
+
+        return table;
+    }
+
+    static constexpr std::array<std::uint32_t, 256> CRC32C_TABLE = generate_crc32c_table();
+
+    static constexpr auto CRC32C_SLICES = detail::generate_crc_slices<std::uint32_t, 16, true>(CRC32C_TABLE);
+
+    namespace detail
+    {
+        using gf2_matrix = std::array<std::uint32_t, 32>;
+
+        constexpr std::uint32_t gf2_matrix_times(const gf2_matrix &mat, std::uint32_t vec)
         {
-            if constexpr (std::is_trivially_copyable_v<_Vty>)
-            {
-                if (can_write<_Vty>())
-                {
-                    *(_Vty *)(m_data + m_pos) = val;
+            std::uint32_t sum = 0;
 
-                    m_pos += sizeof(_Vty);
-                }
-            }
-            else
+            for (size_t i = 0; vec; vec >>= 1, ++i)
             {
-                serialize_object(*this, val);
+                if (vec & 1)
+                    sum ^= mat[i];
             }
+
+            return sum;
         }
 
-        void write(const uint8_t *data, size_t length)
+        constexpr gf2_matrix gf2_matrix_square(const gf2_matrix &mat)
         {
-            auto _copy_len = (std::min)(length, m_length - m_pos);
+            gf2_matrix square = {};
 
-            if (_copy_len > 0)
-            {
-                memcpy(m_data + m_pos, data, _copy_len);
+            for (size_t n = 0; n < 32; ++n)
+                square[n] = gf2_matrix_times(mat, mat[n]);
 
-                m_pos += _copy_len;
-            }
+            return square;
         }
 
-        template <class _Vty>
-        bytes_writer_bounded &operator<<(const _Vty &val)
+        /*
+         * Operator that advances a reflected crc register over `length` zero bytes, `length` must be a power of two
+         */
+        constexpr gf2_matrix crc32_zeros_operator(std::uint32_t poly, size_t length)
         {
-            this->write(val);
+            /* operator for one zero bit */
+            gf2_matrix op = {};
 
-            return *this;
+            op[0] = poly;
+
+            for (size_t n = 1; n < 32; ++n)
+                op[n] = std::uint32_t{1} << (n - 1);
+
+            /* square up to one zero byte, then once per doubling of the length */
+            for (int i = 0; i < 3; ++i)
+                op = gf2_matrix_square(op);
+
+            for (; length > 1; length >>= 1)
+                op = gf2_matrix_square(op);
+
+            return op;
         }
 
-        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
-        bool can_write() const
+        /* byte-indexed tables applying crc32_zeros_operator() to a whole register */
+        constexpr std::array<std::array<std::uint32_t, 256>, 4> generate_crc32_zeros_table(std::uint32_t poly, size_t length)
         {
-            return remaining() >= sizeof(_Vty);
-        }
+            auto op = crc32_zeros_operator(poly, length);
 
-        void reset(uint8_t *data, size_t length)
-        {
-            m_pos = 0;
-            m_data = data;
-            m_length = length;
-        }
+            std::array<std::array<std::uint32_t, 256>, 4> table = {};
 
-        /*
-         * Get the total bytes written
-         */
-        size_t count() const
-        {
-            return m_pos;
+            for (std::uint32_t n = 0; n < 256; ++n)
+            {
+                table[0][n] = gf2_matrix_times(op, n);
+                table[1][n] = gf2_matrix_times(op, n << 8);
+                table[2][n] = gf2_matrix_times(op, n << 16);
+                table[3][n] = gf2_matrix_times(op, n << 24);
+            }
+
+            return table;
         }
 
-        size_t remaining() const
+        inline std::uint32_t crc32_shift(const std::array<std::array<std::uint32_t, 256>, 4> &zeros, std::uint32_t crc)
         {
-            return m_length - m_pos;
+            return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^ zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
         }
 
-    private:
-        uint8_t *m_data{nullptr};
-        size_t m_pos{0};
-        size_t m_length{0};
-    };
-
-    template <class _Ty>
-    constexpr size_t get_size(const _Ty &);
+        using gf2_operators = std::array<gf2_matrix, sizeof(size_t) * 8>;
 
-    namespace detail
-    {
-        template <class _Variant, size_t... _Indices>
-        constexpr size_t get_variant_size_impl(const _Variant &variant, std::index_sequence<_Indices...>)
+        /* operators[n] advances a reflected crc register over 2^n zero bytes, built at run time to keep compile times down */
+        inline gf2_operators generate_crc32_zeros_operators(std::uint32_t poly)
         {
-            using _Get_variant_size_t = size_t (*)(const _Variant &);
+            gf2_operators operators = {};
 
-            constexpr _Get_variant_size_t _table[] =
-                {
-                    [](const _Variant &variant) -> size_t
-                    {
-                        using value_type = std::variant_alternative_t<_Indices, _Variant>;
-                        return get_size<value_type>(std::get<value_type>(variant));
-                    }...};
+            operators[0] = crc32_zeros_operator(poly, 1);
 
-            return _table[variant.index()](variant);
+            for (size_t n = 1; n < operators.size(); ++n)
+                operators[n] = gf2_matrix_square(operators[n - 1]);
+
+            return operators;
         }
 
-        template <class _Tuple, size_t... _Indices>
-        constexpr size_t get_tuple_size_impl(const _Tuple &tuple, std::index_sequence<_Indices...>)
+        /*
+         * Crc of two adjacent blocks from the crcs of both, the first one is advanced over the zero bytes of the second
+         * The initial value and the final inversion cancel out, so it works on finalized crcs
+         */
+        inline std::uint32_t crc32_combine(const gf2_operators &operators, std::uint32_t crc1, std::uint32_t crc2, size_t length2)
         {
-            const size_t _sizes[] = {get_size<std::tuple_element_t<_Indices, _Tuple>>(std::get<_Indices>(tuple))...};
+            for (size_t n = 0; length2 != 0; length2 >>= 1, ++n)
+            {
+                if (length2 & 1)
+                    crc1 = gf2_matrix_times(operators[n], crc1);
+            }
 
-            return std::accumulate(_sizes, _sizes + std::tuple_size_v<_Tuple>, (size_t)0);
+            return crc1 ^ crc2;
         }
 
-        template <class _Tuple, class _Writer, size_t... _Indices>
-        void serialize_tuple_impl(_Writer &writer, const _Tuple &tuple, std::index_sequence<_Indices...>)
+        inline std::uint32_t crc32_combine(std::uint32_t crc1, std::uint32_t crc2, size_t length2)
         {
-            (writer << ... << std::get<_Indices>(tuple));
+            static const gf2_operators operators = generate_crc32_zeros_operators(_polynomial_crc32);
+
+            return crc32_combine(operators, crc1, crc2, length2);
         }
 
-        template <class _Variant, class _Reader, size_t... _Indices>
-        _Variant deserialize_variant_impl(_Reader &reader, uint32_t index, std::index_sequence<_Indices...>)
+        inline std::uint32_t crc32c_combine(std::uint32_t crc1, std::uint32_t crc2, size_t length2)
         {
-            using _Variant_deserializer_t = _Variant (*)(_Reader &);
-
-            constexpr _Variant_deserializer_t _table[] =
-                {
-                    [](_Reader &reader) -> _Variant
-                    {
-                        using value_type = std::variant_alternative_t<_Indices, _Variant>;
-
-                        return _Variant{reader.template read<value_type>()};
-                    }...};
+            static const gf2_operators operators = generate_crc32_zeros_operators(_polynomial_crc32c);
 
-            return _table[index](reader);
+            return crc32_combine(operators, crc1, crc2, length2);
         }
 
-        template <class _Tuple, class _Reader, size_t... _Indices>
-        _Tuple deserialize_tuple_impl(_Reader &reader, std::index_sequence<_Indices...>)
+        inline std::uint32_t crc32c_update_table(std::uint32_t crc, const uint8_t *data, size_t length)
         {
-            _Tuple __t{};
+            for (; length >= 16; data += 16, length -= 16)
+            {
+                crc ^= static_cast<std::uint32_t>(data[0]) | static_cast<std::uint32_t>(data[1]) << 8 |
+                       static_cast<std::uint32_t>(data[2]) << 16 | static_cast<std::uint32_t>(data[3]) << 24;
+
+                crc = CRC32C_SLICES[15][crc & 0xff] ^ CRC32C_SLICES[14][(crc >> 8) & 0xff] ^
+                      CRC32C_SLICES[13][(crc >> 16) & 0xff] ^ CRC32C_SLICES[12][crc >> 24] ^
+                      CRC32C_SLICES[11][data[4]] ^ CRC32C_SLICES[10][data[5]] ^
+                      CRC32C_SLICES[9][data[6]] ^ CRC32C_SLICES[8][data[7]] ^
+                      CRC32C_SLICES[7][data[8]] ^ CRC32C_SLICES[6][data[9]] ^
+                      CRC32C_SLICES[5][data[10]] ^ CRC32C_SLICES[4][data[11]] ^
+                      CRC32C_SLICES[3][data[12]] ^ CRC32C_SLICES[2][data[13]] ^
+                      CRC32C_SLICES[1][data[14]] ^ CRC32C_SLICES[0][data[15]];
+            }
 
-            (reader >> ... >> std::get<_Indices>(__t));
+            for (size_t i = 0; i < length; ++i)
+                crc = (crc >> 8) ^ CRC32C_TABLE[(crc ^ data[i]) & 0xFF];
 
-            return __t;
+            return crc;
         }
-    }
 
-    template <class _Ty>
-    constexpr void get_object_size(const _Ty &object, size_t &size)
-    {
-        constexpr size_t header_size = sizeof(data_header);
+#ifdef ZPACKER_SIMD
+        /* block lengths of the three interleaved streams, the crc32 instruction has a latency of 3 cycles */
+        constexpr size_t _crc32c_long = 8192;
+        constexpr size_t _crc32c_short = 256;
 
-        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be serialized can not be pointer type");
+        static constexpr auto CRC32C_LONG_ZEROS = generate_crc32_zeros_table(_polynomial_crc32c, _crc32c_long);
+        static constexpr auto CRC32C_SHORT_ZEROS = generate_crc32_zeros_table(_polynomial_crc32c, _crc32c_short);
 
-        if constexpr (has_get_size_v<_Ty>)
-        {
-            size += object.get_size();
-        }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::pair>)
+        inline std::uint64_t crc32c_load64(const uint8_t *data)
         {
-            size += sizeof(data_header);
+            std::uint64_t value;
 
-            get_object_size(object.first, size);
-            get_object_size(object.second, size);
+            memcpy(&value, data, sizeof(value));
+
+            return value;
         }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::variant>)
+
+        template <size_t _Block>
+        ZPACKER_TARGET("sse4.2")
+        inline std::uint64_t crc32c_update_interleaved(std::uint64_t crc0, const uint8_t *&data, size_t &length,
+                                                       const std::array<std::array<std::uint32_t, 256>, 4> &zeros)
         {
-            using _Variant = remove_cvref_t<_Ty>;
+            while (length >= _Block * 3)
+            {
+                std::uint64_t crc1 = 0;
+                std::uint64_t crc2 = 0;
 
-            size += sizeof(data_header);
+                for (auto end = data + _Block; data < end; data += 8)
+                {
+                    crc0 = _mm_crc32_u64(crc0, crc32c_load64(data));
+                    crc1 = _mm_crc32_u64(crc1, crc32c_load64(data + _Block));
+                    crc2 = _mm_crc32_u64(crc2, crc32c_load64(data + _Block * 2));
+                }
 
-            size += detail::get_variant_size_impl(object, std::make_index_sequence<std::variant_size_v<_Variant>>{});
-        }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::tuple>)
-        {
-            using _Tuple = remove_cvref_t<_Ty>;
+                crc0 = crc32_shift(zeros, static_cast<std::uint32_t>(crc0)) ^ crc1;
+                crc0 = crc32_shift(zeros, static_cast<std::uint32_t>(crc0)) ^ crc2;
 
-            size += sizeof(data_header);
+                data += _Block * 2;
+                length -= _Block * 3;
+            }
 
-            size += detail::get_tuple_size_impl(object, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+            return crc0;
         }
-        else if constexpr (is_standard_container_v<remove_cvref_t<_Ty>>)
+
+        ZPACKER_TARGET("sse4.2")
+        inline std::uint32_t crc32c_update_hw(std::uint32_t crc, const uint8_t *data, size_t length)
         {
-            using value_type = typename remove_cvref_t<_Ty>::value_type;
+            std::uint64_t crc0 = crc;
 
-            size += header_size;
+            crc0 = crc32c_update_interleaved<_crc32c_long>(crc0, data, length, CRC32C_LONG_ZEROS);
+            crc0 = crc32c_update_interleaved<_crc32c_short>(crc0, data, length, CRC32C_SHORT_ZEROS);
 
-            /* with this constexpr, compiler can generate more efficient code */
-            if constexpr (get_data_type<value_type>() < d_pod)
-            {
-                size += sizeof(value_type) * object.size();
-            }
-            else
-            {
-                std::for_each(object.begin(), object.end(), [&size](auto &v)
-                              { get_object_size(v, size); });
-            }
-        }
-        else if constexpr (has_iterator_v<remove_cvref_t<_Ty>> && has_value_type_v<remove_cvref_t<_Ty>>)
-        {
-            using value_type = typename remove_cvref_t<_Ty>::value_type;
+            for (; length >= 8; data += 8, length -= 8)
+                crc0 = _mm_crc32_u64(crc0, crc32c_load64(data));
 
-            size += header_size;
+            auto crc32 = static_cast<std::uint32_t>(crc0);
 
-            if constexpr (get_data_type<value_type>() < d_pod)
-            {
-                size += sizeof(value_type) * object.size();
-            }
-            else
-            {
-                std::for_each(object.begin(), object.end(), [&size](auto &v)
-                              { get_object_size(v, size); });
-            }
-        }
-        else if constexpr (std::is_trivially_copyable_v<remove_cvref_t<_Ty>>)
-        {
-            if constexpr (std::is_compound_v<_Ty>)
-            {
-                size += header_size;
-            }
+            for (; length > 0; ++data, --length)
+                crc32 = _mm_crc32_u8(crc32, *data);
 
-            size += sizeof(_Ty);
+            return crc32;
         }
-        else
+#endif
+
+        inline std::uint32_t crc32c_update(std::uint32_t crc, const uint8_t *data, size_t length)
         {
-            static_assert(
-                Always_false<_Ty>,
-                "_Ty must implement \"size_t _Ty::get_size() const\"");
+#ifdef ZPACKER_SIMD
+            if (get_cpu_features().sse42)
+                return crc32c_update_hw(crc, data, length);
+#endif
+            return crc32c_update_table(crc, data, length);
         }
     }
 
     /*
-     * Calculate the memory space size needed for serialization / deserialization of the object
+     * CRC-32C (Castagnoli), computed by the SSE4.2 crc32 instruction when available
      */
-    template <class _Ty>
-    constexpr size_t get_size(const _Ty &object)
+    struct crc32c_checksum
     {
-        size_t result{};
+        static constexpr checksum_type type = ct_crc32c;
 
-        get_object_size(object, result);
+        using state_type = std::uint32_t;
 
-        return result;
-    }
+        state_type init() const
+        {
+            return 0xFFFFFFFF;
+        }
 
-    /*
-     * Serialize a object to binary format
-     */
-    template <class _Ty, class _Writer = bytes_writer>
-    void serialize_object(_Writer &writer, const _Ty &object)
-    {
-        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be serialized can not be pointer type");
+        void update(state_type &state, const uint8_t *data, size_t length) const
+        {
+            state = detail::crc32c_update(state, data, length);
+        }
 
-        if constexpr (has_serialize_v<_Ty>)
+        std::uint32_t finalize(const state_type &state) const
         {
-            object.serialize(writer);
+            return ~state;
         }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::pair>)
+
+        std::uint32_t operator()(const uint8_t *data, size_t length) const
         {
-            data_header _header{d_pair, 2};
+            return ~detail::crc32c_update(0xFFFFFFFF, data, length);
+        }
 
-            writer << _header;
+        /*
+         * Checksum of two adjacent blocks from the checksums of both, `length` is the size of the second block
+         */
+        std::uint32_t combine(std::uint32_t first, std::uint32_t second, size_t length) const
+        {
+            return detail::crc32c_combine(first, second, length);
+        }
+    };
 
-            using _first_type = typename remove_cvref_t<_Ty>::first_type;
-            using _second_type = typename remove_cvref_t<_Ty>::second_type;
+    namespace detail
+    {
+        constexpr std::uint64_t _xxh_prime64_1 = 0x9E3779B185EBCA87ULL;
+        constexpr std::uint64_t _xxh_prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr std::uint64_t _xxh_prime64_3 = 0x165667B19E3779F9ULL;
+        constexpr std::uint64_t _xxh_prime64_4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr std::uint64_t _xxh_prime64_5 = 0x27D4EB2F165667C5ULL;
 
-            writer << object.first;
-            writer << object.second;
+        constexpr std::uint64_t rotl64(std::uint64_t value, int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
         }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::variant>)
+
+        inline std::uint64_t xxh_read64(const uint8_t *data)
         {
-            using _Variant = remove_cvref_t<_Ty>;
+            std::uint64_t value;
 
-            data_header _header{d_variant, std::variant_size_v<_Variant>};
+            memcpy(&value, data, sizeof(value));
 
-            std::visit([&_header, &writer, &object](auto &&val)
-                       {
-				using value_type = std::decay_t<decltype(val)>;
+            return value;
+        }
 
-				_header.set_sub_type(get_data_type<value_type>());
+        inline std::uint32_t xxh_read32(const uint8_t *data)
+        {
+            std::uint32_t value;
 
-				writer << _header << static_cast<uint32_t>(object.index()) << val; }, object);
+            memcpy(&value, data, sizeof(value));
+
+            return value;
         }
-        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::tuple>)
-        {
-            using _Tuple = remove_cvref_t<_Ty>;
 
-            writer << data_header{d_tuple, std::tuple_size_v<_Tuple>};
+        constexpr std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t input)
+        {
+            acc += input * _xxh_prime64_2;
+            acc = rotl64(acc, 31);
 
-            detail::serialize_tuple_impl(writer, object, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+            return acc * _xxh_prime64_1;
         }
-        else if constexpr (is_standard_container_v<remove_cvref_t<_Ty>>)
+
+        constexpr std::uint64_t xxh64_merge_round(std::uint64_t acc, std::uint64_t value)
         {
-            using container_type = remove_cvref_t<_Ty>;
-            using value_type = typename container_type::value_type;
+            acc ^= xxh64_round(0, value);
 
-            data_header _header{};
+            return acc * _xxh_prime64_1 + _xxh_prime64_4;
+        }
 
-            if constexpr (is_sequence_container_v<container_type>)
+        /* mix the tail of less than 32 bytes into the hash and run the final avalanche */
+        inline std::uint64_t xxh64_finalize(std::uint64_t hash, const uint8_t *data, size_t length)
+        {
+            for (; length >= 8; data += 8, length -= 8)
             {
-                _header.set_main_type(d_seq_container);
-                _header.set_sub_type(get_data_type<value_type>());
+                hash ^= xxh64_round(0, xxh_read64(data));
+                hash = rotl64(hash, 27) * _xxh_prime64_1 + _xxh_prime64_4;
             }
-            else if constexpr (is_associated_container_v<container_type>)
+
+            if (length >= 4)
             {
-                _header.set_main_type(d_aso_container);
-                _header.set_sub_type(get_data_type<value_type>());
+                hash ^= static_cast<std::uint64_t>(xxh_read32(data)) * _xxh_prime64_1;
+                hash = rotl64(hash, 23) * _xxh_prime64_2 + _xxh_prime64_3;
+
+                data += 4;
+                length -= 4;
             }
-            /* std::array, std::initializer_list, etc. */
-            else
+
+            for (; length > 0; ++data, --length)
             {
-                _header.set_main_type(d_seq_container);
-                _header.set_sub_type(get_data_type<value_type>());
+                hash ^= *data * _xxh_prime64_5;
+                hash = rotl64(hash, 11) * _xxh_prime64_1;
             }
 
-            _header.length = static_cast<std::uint32_t>(object.size());
-
-            writer << _header;
+            hash ^= hash >> 33;
+            hash *= _xxh_prime64_2;
+            hash ^= hash >> 29;
+            hash *= _xxh_prime64_3;
+            hash ^= hash >> 32;
 
-            std::for_each(object.begin(), object.end(), [&writer](auto &v)
-                          { writer << v; });
+            return hash;
         }
-        /* std::forward_list goes here */
-        else if constexpr (has_iterator_v<remove_cvref_t<_Ty>> && has_value_type_v<remove_cvref_t<_Ty>>)
+
+        /* state of an incremental XXH64, stripes are buffered until 32 bytes are available */
+        struct xxh64_state
         {
-            using container_type = remove_cvref_t<_Ty>;
-            using value_type = typename container_type::value_type;
+            std::uint64_t lanes[4];
+            std::uint64_t seed;
+            std::uint64_t total;
+            uint8_t buffer[32];
+            size_t buffered;
+        };
+
+        inline xxh64_state xxh64_init(std::uint64_t seed)
+        {
+            xxh64_state state{};
 
-            data_header _header{};
+            state.lanes[0] = seed + _xxh_prime64_1 + _xxh_prime64_2;
+            state.lanes[1] = seed + _xxh_prime64_2;
+            state.lanes[2] = seed;
+            state.lanes[3] = seed - _xxh_prime64_1;
+            state.seed = seed;
 
-            _header.set_main_type(d_seq_container);
-            _header.set_sub_type(get_data_type<value_type>());
+            return state;
+        }
 
-            if constexpr (has_size_v<container_type>)
+        /*
+         * Consume the whole 32-byte stripes of data, return the number of bytes consumed
+         */
+        inline size_t xxh64_stripes(std::uint64_t *lanes, const uint8_t *data, size_t length)
+        {
+            std::uint64_t v1 = lanes[0];
+            std::uint64_t v2 = lanes[1];
+            std::uint64_t v3 = lanes[2];
+            std::uint64_t v4 = lanes[3];
+            size_t consumed = 0;
+
+            /* four independent lanes keep the multipliers busy */
+            for (; length - consumed >= 32; consumed += 32)
             {
-                _header.length = static_cast<std::uint32_t>(object.size());
+                v1 = xxh64_round(v1, xxh_read64(data + consumed));
+                v2 = xxh64_round(v2, xxh_read64(data + consumed + 8));
+                v3 = xxh64_round(v3, xxh_read64(data + consumed + 16));
+                v4 = xxh64_round(v4, xxh_read64(data + consumed + 24));
+            }
 
-                writer << _header;
+            lanes[0] = v1;
+            lanes[1] = v2;
+            lanes[2] = v3;
+            lanes[3] = v4;
 
-                std::for_each(object.begin(), object.end(), [&writer](auto &v)
-                              { writer << v; });
-            }
-            else
+            return consumed;
+        }
+
+        inline void xxh64_update(xxh64_state &state, const uint8_t *data, size_t length)
+        {
+            state.total += length;
+
+            if (state.buffered > 0)
             {
-                std::uint32_t _size{0};
-                std::vector<uint8_t> _partial;
+                auto fill = (std::min)(length, sizeof(state.buffer) - state.buffered);
 
-                _partial.reserve(_default_reserve_size);
+                memcpy(state.buffer + state.buffered, data, fill);
 
-                bytes_writer _writer{_partial};
+                state.buffered += fill;
+                data += fill;
+                length -= fill;
 
-                std::for_each(object.begin(), object.end(), [&_writer, &_partial, &_size](auto &v)
-                              {
-					_writer << v;
-					++_size; });
+                if (state.buffered < sizeof(state.buffer))
+                    return;
 
-                _header.length = _size;
+                xxh64_stripes(state.lanes, state.buffer, sizeof(state.buffer));
 
-                _partial.shrink_to_fit();
+                state.buffered = 0;
+            }
 
-                writer << _header;
+            auto consumed = xxh64_stripes(state.lanes, data, length);
 
-                writer.write(_partial);
+            if (length > consumed)
+            {
+                memcpy(state.buffer, data + consumed, length - consumed);
+
+                state.buffered = length - consumed;
             }
         }
-        else if constexpr (std::is_trivially_copyable_v<remove_cvref_t<_Ty>>)
+
+        inline std::uint64_t xxh64_digest(const xxh64_state &state)
         {
-            if constexpr (std::is_compound_v<_Ty>)
+            std::uint64_t hash;
+
+            if (state.total >= 32)
             {
-                writer << data_header{d_pod, static_cast<std::uint32_t>(sizeof(_Ty))};
+                const auto &v = state.lanes;
+
+                hash = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+                hash = xxh64_merge_round(hash, v[0]);
+                hash = xxh64_merge_round(hash, v[1]);
+                hash = xxh64_merge_round(hash, v[2]);
+                hash = xxh64_merge_round(hash, v[3]);
+            }
+            else
+            {
+                hash = state.seed + _xxh_prime64_5;
+            }
+
+            hash += state.total;
+
+            return xxh64_finalize(hash, state.buffer, state.buffered);
+        }
+
+        inline std::uint64_t xxh64(const uint8_t *data, size_t length, std::uint64_t seed)
+        {
+            auto state = xxh64_init(seed);
+
+            xxh64_update(state, data, length);
+
+            return xxh64_digest(state);
+        }
+    }
+
+    /*
+     * 64-bit XXH64 hash, a non-cryptographic checksum running near memory bandwidth
+     */
+    struct xxh64_checksum
+    {
+        static constexpr checksum_type type = ct_xxh64;
+
+        std::uint64_t seed{0};
+
+        using state_type = detail::xxh64_state;
+
+        state_type init() const
+        {
+            return detail::xxh64_init(seed);
+        }
+
+        void update(state_type &state, const uint8_t *data, size_t length) const
+        {
+            detail::xxh64_update(state, data, length);
+        }
+
+        std::uint64_t finalize(const state_type &state) const
+        {
+            return detail::xxh64_digest(state);
+        }
+
+        std::uint64_t operator()(const uint8_t *data, size_t length) const
+        {
+            return detail::xxh64(data, length, seed);
+        }
+    };
+
+    constexpr size_t _default_reserve_size = 4096;
+
+    /*
+     * Tag of the top-level serialize APIs, the output size is computed by get_size() up front
+     * so the payload is written with a single allocation
+     */
+    struct exact_size_t
+    {
+        explicit exact_size_t() = default;
+    };
+
+    inline constexpr exact_size_t exact_size{};
+
+    /*
+     * Tag of the top-level serialize and deserialize APIs for the compact wire format, see compact_writer
+     */
+    struct compact_t
+    {
+        explicit compact_t() = default;
+    };
+
+    inline constexpr compact_t compact{};
+
+    namespace detail
+    {
+        template <class _Ty>
+        auto codec_type_impl(int) -> std::integral_constant<codec_type, _Ty::type>;
+
+        template <class _Ty>
+        std::integral_constant<codec_type, cd_custom> codec_type_impl(...);
+    }
+
+    /* the codec_type recorded for an encoder or decoder policy */
+    template <class _Codec>
+    constexpr codec_type codec_type_v = decltype(detail::codec_type_impl<_Codec>(0))::value;
+
+    struct empty_encoder
+    {
+        static constexpr codec_type type = cd_none;
+
+        std::vector<uint8_t> operator()(const void *input, size_t length) const
+        {
+            return std::vector<uint8_t>{(uint8_t *)input, (uint8_t *)input + length};
+        }
+    };
+
+    struct empty_decoder
+    {
+        static constexpr codec_type type = cd_none;
+
+        std::vector<uint8_t> operator()(const void *input, size_t length) const
+        {
+            return std::vector<uint8_t>{(uint8_t *)input, (uint8_t *)input + length};
+        }
+    };
+
+    namespace detail
+    {
+        constexpr size_t _lz4_min_match = 4;
+        constexpr size_t _lz4_last_literals = 5;    // the block always ends with this many literals
+        constexpr size_t _lz4_match_limit = 12;     // no match starts in the last bytes of the block
+        constexpr size_t _lz4_max_offset = 65535;
+        constexpr unsigned _lz4_hash_log = 14;
+        constexpr unsigned _lz4_skip_trigger = 6;   // the search step grows after 2^6 misses
+        constexpr size_t _lz4_slack = 32;           // extra room of the decode buffer for the 8-byte copies
+
+        inline std::uint32_t lz4_hash(const uint8_t *data)
+        {
+            std::uint32_t value;
+
+            memcpy(&value, data, sizeof(value));
+
+            return (value * 2654435761U) >> (32 - _lz4_hash_log);
+        }
+
+        inline bool lz4_equal32(const uint8_t *lhs, const uint8_t *rhs)
+        {
+            std::uint32_t a, b;
+
+            memcpy(&a, lhs, sizeof(a));
+            memcpy(&b, rhs, sizeof(b));
+
+            return a == b;
+        }
+
+        inline unsigned trailing_zero_bytes(std::uint64_t diff)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(diff)) >> 3;
+#else
+            unsigned count = 0;
+
+            for (; (diff & 0xff) == 0; diff >>= 8)
+                ++count;
+
+            return count;
+#endif
+        }
+
+        /*
+         * Length of the common prefix of `data` and `match`, `data` stops at `limit`
+         */
+        inline size_t lz4_match_length(const uint8_t *data, const uint8_t *match, const uint8_t *limit)
+        {
+            auto start = data;
+
+            while (data + sizeof(std::uint64_t) <= limit)
+            {
+                std::uint64_t a, b;
+
+                memcpy(&a, data, sizeof(a));
+                memcpy(&b, match, sizeof(b));
+
+                if (a != b)
+                    return static_cast<size_t>(data - start) + trailing_zero_bytes(a ^ b);
+
+                data += sizeof(std::uint64_t);
+                match += sizeof(std::uint64_t);
+            }
+
+            while (data < limit && *data == *match)
+            {
+                ++data;
+                ++match;
+            }
+
+            return static_cast<size_t>(data - start);
+        }
+
+        inline uint8_t *lz4_write_length(uint8_t *out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                *out++ = 255;
+
+            *out++ = static_cast<uint8_t>(length);
+
+            return out;
+        }
+
+        inline uint8_t *lz4_write_sequence(uint8_t *out, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length)
+        {
+            auto token = out++;
+
+            if (literal_length >= 15)
+            {
+                *token = 15 << 4;
+                out = lz4_write_length(out, literal_length - 15);
+            }
+            else
+            {
+                *token = static_cast<uint8_t>(literal_length << 4);
+            }
+
+            if (literal_length > 0)
+                memcpy(out, literals, literal_length);
+
+            out += literal_length;
+
+            // the last sequence carries literals only
+            if (match_length == 0)
+                return out;
+
+            *out++ = static_cast<uint8_t>(offset);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+
+            match_length -= _lz4_min_match;
+
+            if (match_length >= 15)
+            {
+                *token |= 15;
+                out = lz4_write_length(out, match_length - 15);
+            }
+            else
+            {
+                *token |= static_cast<uint8_t>(match_length);
+            }
+
+            return out;
+        }
+
+        /*
+         * Worst case size of an LZ4 block of `length` input bytes
+         */
+        constexpr size_t lz4_compress_bound(size_t length)
+        {
+            return length + length / 255 + 16;
+        }
+
+        /*
+         * Greedy single-pass LZ4 block compressor, returns the end of the block written to `out`
+         */
+        inline uint8_t *lz4_compress_block(const uint8_t *input, size_t length, uint8_t *out)
+        {
+            auto anchor = input;
+            auto end = input + length;
+
+            if (length > _lz4_match_limit)
+            {
+                std::vector<std::uint32_t> table(size_t{1} << _lz4_hash_log);
+
+                auto match_limit = end - _lz4_last_literals;
+                auto search_limit = end - _lz4_match_limit;
+                auto ip = input + 1;
+
+                table[lz4_hash(input)] = 0;
+
+                while (ip < search_limit)
+                {
+                    const uint8_t *match = nullptr;
+                    size_t attempts = size_t{1} << _lz4_skip_trigger;
+
+                    // find a match, the step grows on incompressible input
+                    for (;;)
+                    {
+                        auto hash = lz4_hash(ip);
+
+                        match = input + table[hash];
+                        table[hash] = static_cast<std::uint32_t>(ip - input);
+
+                        if (static_cast<size_t>(ip - match) <= _lz4_max_offset && match < ip && lz4_equal32(ip, match))
+                            break;
+
+                        ip += attempts++ >> _lz4_skip_trigger;
+
+                        if (ip >= search_limit)
+                            break;
+                    }
+
+                    if (ip >= search_limit)
+                        break;
+
+                    // extend backwards over the pending literals
+                    while (ip > anchor && match > input && ip[-1] == match[-1])
+                    {
+                        --ip;
+                        --match;
+                    }
+
+                    auto match_length = _lz4_min_match + lz4_match_length(ip + _lz4_min_match, match + _lz4_min_match, match_limit);
+
+                    out = lz4_write_sequence(out, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - match), match_length);
+
+                    ip += match_length;
+                    anchor = ip;
+
+                    if (ip >= search_limit)
+                        break;
+
+                    table[lz4_hash(ip - 2)] = static_cast<std::uint32_t>(ip - 2 - input);
+                }
+            }
+
+            return lz4_write_sequence(out, anchor, static_cast<size_t>(end - anchor), 0, 0);
+        }
+
+        /*
+         * Copy in 8-byte steps, it may write up to 7 bytes past `dst_end`
+         */
+        inline void lz4_wild_copy(uint8_t *dst, const uint8_t *src, uint8_t *dst_end)
+        {
+            do
+            {
+                memcpy(dst, src, 8);
+
+                dst += 8;
+                src += 8;
+            } while (dst < dst_end);
+        }
+
+        inline bool lz4_read_length(const uint8_t *&ip, const uint8_t *end, size_t &length)
+        {
+            uint8_t value;
+
+            do
+            {
+                if (ip >= end)
+                    return false;
+
+                value = *ip++;
+                length += value;
+            } while (value == 255);
+
+            return true;
+        }
+
+        /*
+         * Decode an LZ4 block of exactly `output_length` bytes to `output`
+         * `output` must have room for _lz4_slack extra bytes, malformed input is rejected
+         */
+        inline bool lz4_decompress_block(const uint8_t *input, size_t length, uint8_t *output, size_t output_length)
+        {
+            auto ip = input;
+            auto end = input + length;
+            auto op = output;
+            auto output_end = output + output_length;
+
+            for (;;)
+            {
+                if (ip >= end)
+                    return false;
+
+                auto token = *ip++;
+
+                size_t literal_length = token >> 4;
+
+                if (literal_length == 15 && !lz4_read_length(ip, end, literal_length))
+                    return false;
+
+                if (literal_length > static_cast<size_t>(end - ip) || literal_length > static_cast<size_t>(output_end - op))
+                    return false;
+
+                if (static_cast<size_t>(end - ip) >= literal_length + 8)
+                    lz4_wild_copy(op, ip, op + literal_length);
+                else
+                    memcpy(op, ip, literal_length);
+
+                op += literal_length;
+                ip += literal_length;
+
+                if (ip == end)
+                    break;
+
+                if (end - ip < 2)
+                    return false;
+
+                size_t offset = ip[0] | (ip[1] << 8);
+
+                ip += 2;
+
+                if (offset == 0 || offset > static_cast<size_t>(op - output))
+                    return false;
+
+                size_t match_length = token & 15;
+
+                if (match_length == 15 && !lz4_read_length(ip, end, match_length))
+                    return false;
+
+                match_length += _lz4_min_match;
+
+                if (match_length > static_cast<size_t>(output_end - op))
+                    return false;
+
+                auto match = op - offset;
+
+                if (offset >= 8)
+                {
+                    lz4_wild_copy(op, match, op + match_length);
+                }
+                else
+                {
+                    // overlapping match, repeats the last `offset` bytes
+                    for (size_t i = 0; i < match_length; ++i)
+                        op[i] = match[i];
+                }
+
+                op += match_length;
+            }
+
+            return op == output_end;
+        }
+    }
+
+    /*
+     * LZ4 block compression, the block is prefixed by the varint encoded size of the input
+     */
+    struct lz4_encoder
+    {
+        static constexpr codec_type type = cd_lz4;
+
+        std::vector<uint8_t> operator()(const void *input, size_t length) const
+        {
+            std::vector<uint8_t> result(10 + detail::lz4_compress_bound(length));
+
+            auto out = result.data();
+
+            for (auto value = length; ; value >>= 7)
+            {
+                if (value < 0x80)
+                {
+                    *out++ = static_cast<uint8_t>(value);
+                    break;
+                }
+
+                *out++ = static_cast<uint8_t>(value | 0x80);
+            }
+
+            out = detail::lz4_compress_block(static_cast<const uint8_t *>(input), length, out);
+
+            result.resize(out - result.data());
+
+            return result;
+        }
+    };
+
+    /*
+     * Decoder of lz4_encoder, an empty vector is returned if the input is malformed
+     */
+    struct lz4_decoder
+    {
+        static constexpr codec_type type = cd_lz4;
+
+        std::vector<uint8_t> operator()(const void *input, size_t length) const
+        {
+            auto ip = static_cast<const uint8_t *>(input);
+            auto end = ip + length;
+
+            size_t decoded_length = 0;
+
+            for (unsigned shift = 0; ; shift += 7)
+            {
+                if (ip >= end || shift >= 64)
+                    return {};
+
+                decoded_length |= static_cast<size_t>(*ip & 0x7f) << shift;
+
+                if ((*ip++ & 0x80) == 0)
+                    break;
+            }
+
+            // a sequence expands at most 255 times
+            if (decoded_length / 255 > static_cast<size_t>(end - ip))
+                return {};
+
+            std::vector<uint8_t> result(decoded_length + detail::_lz4_slack);
+
+            if (!detail::lz4_decompress_block(ip, static_cast<size_t>(end - ip), result.data(), decoded_length))
+                return {};
+
+            result.resize(decoded_length);
+
+            return result;
+        }
+    };
+
+    // forward declaration
+    template <class _Ty, class _Writer>
+    void serialize_object(_Writer &, const _Ty &);
+
+    template <
+        class _Ty,
+        class _Reader,
+        class>
+    _Ty deserialize_object(_Reader &);
+
+    class bytes_reader
+    {
+    public:
+        bytes_reader(const std::vector<uint8_t> &data) : m_data(std::addressof(data)) {}
+
+        template <class _Vty>
+        _Vty read()
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                if (!can_read<_Vty>())
+                    return _Vty{};
+
+                auto result = *reinterpret_cast<_Vty *>(const_cast<uint8_t *>(m_data->data()) + m_pos);
+
+                m_pos += sizeof(_Vty);
+
+                return result;
+            }
+            else
+            {
+                return deserialize_object<_Vty>(*this);
+            }
+        }
+
+        template <class _Vty>
+        bytes_reader &operator>>(_Vty &val)
+        {
+            val = this->read<_Vty>();
+
+            return *this;
+        }
+
+        std::vector<uint8_t> read_bytes(size_t count)
+        {
+            auto available = (std::min)(count, remaining());
+
+            auto result = std::vector<uint8_t>{m_data->data() + m_pos, m_data->data() + m_pos + available};
+
+            m_pos += available;
+
+            return result;
+        }
+
+        /*
+         * Copy `length` bytes out to `data`, nothing is read if there are not enough bytes remaining
+         */
+        bool read(uint8_t *data, size_t length)
+        {
+            if (remaining() < length)
+                return false;
+
+            // an empty container may hand in a null `data`
+            if (length != 0)
+                memcpy(data, m_data->data() + m_pos, length);
+
+            m_pos += length;
+
+            return true;
+        }
+
+        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
+        bool can_read() const
+        {
+            return remaining() >= sizeof(_Vty);
+        }
+
+        size_t remaining() const
+        {
+            return m_data->size() - m_pos;
+        }
+
+        /*
+         * Return total bytes that has been read out for now
+         * It also represent current buffer read position
+         */
+        size_t count() const
+        {
+            return m_pos;
+        }
+
+        /*
+         * Get the beginning of the underlying buffer
+         */
+        const uint8_t *data() const
+        {
+            return m_data->data();
+        }
+
+        void skip(size_t count)
+        {
+            if (remaining() >= count)
+                m_pos += count;
+        }
+
+        void seek(size_t pos)
+        {
+            if (pos < m_data->size() - count())
+                m_pos = pos;
+        }
+
+        void reset(const std::vector<uint8_t> *data)
+        {
+            m_pos = 0;
+            m_data = data;
+        }
+
+    private:
+        size_t m_pos{0};
+        const std::vector<uint8_t> *m_data;
+    };
+
+    class bytes_reader_bounded
+    {
+    public:
+        bytes_reader_bounded(const uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+
+        template <class _Vty>
+        _Vty read()
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                static_assert(std::is_default_constructible_v<_Vty>, "_Vty must be default constructible");
+
+                if (!can_read<_Vty>())
+                    return _Vty{};
+
+                auto result = *reinterpret_cast<const _Vty *>(m_data + m_pos);
+
+                m_pos += sizeof(_Vty);
+
+                return result;
+            }
+            else
+            {
+                return deserialize_object<_Vty>(*this);
+            }
+        }
+
+        template <class _Vty>
+        bytes_reader_bounded &operator>>(_Vty &val)
+        {
+            val = this->read<_Vty>();
+
+            return *this;
+        }
+
+        std::vector<uint8_t> read_bytes(size_t count)
+        {
+            auto available = (std::min)(count, remaining());
+
+            auto result = std::vector<uint8_t>{m_data + m_pos, m_data + m_pos + available};
+
+            m_pos += available;
+
+            return result;
+        }
+
+        /*
+         * Copy `length` bytes out to `data`, nothing is read if there are not enough bytes remaining
+         */
+        bool read(uint8_t *data, size_t length)
+        {
+            if (remaining() < length)
+                return false;
+
+            // an empty container may hand in a null `data`
+            if (length != 0)
+                memcpy(data, m_data + m_pos, length);
+
+            m_pos += length;
+
+            return true;
+        }
+
+        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
+        bool can_read() const
+        {
+            return remaining() >= sizeof(_Vty);
+        }
+
+        size_t remaining() const
+        {
+            return m_length - m_pos;
+        }
+
+        void skip(size_t count)
+        {
+            if (remaining() >= count)
+                m_pos += count;
+        }
+
+        size_t count() const
+        {
+            return m_pos;
+        }
+
+        /*
+         * Get the beginning of the underlying buffer
+         */
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        void seek(size_t pos)
+        {
+            if (pos < m_length - count())
+                m_pos = pos;
+        }
+
+        void reset(const uint8_t *data, size_t length)
+        {
+            m_pos = 0;
+            m_data = data;
+            m_length = length;
+        }
+
+    private:
+        size_t m_pos{0};
+        const uint8_t *m_data{nullptr};
+        size_t m_length{0};
+    };
+
+    class bytes_writer
+    {
+    public:
+        bytes_writer(std::vector<uint8_t> &data) : m_data(std::addressof(data)) {}
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                auto begin = (uint8_t *)std::addressof(val);
+
+                m_data->insert(m_data->end(), begin, begin + sizeof(_Vty));
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            m_data->insert(m_data->end(), data.begin(), data.end());
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            m_data->insert(m_data->end(), data, data + length);
+        }
+
+        template <class _Vty>
+        bytes_writer &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        void reset(std::vector<uint8_t> &data)
+        {
+            m_data = std::addressof(data);
+        }
+
+        template <class _Ty>
+        constexpr bool can_write() const
+        {
+            return true;
+        }
+
+        /*
+         * Get the total bytes written
+         */
+        size_t count() const
+        {
+            return m_data->size();
+        }
+
+        /*
+         * Get the beginning of the underlying buffer
+         */
+        const uint8_t *data() const
+        {
+            return m_data->data();
+        }
+
+    private:
+        std::vector<uint8_t> *m_data;
+    };
+
+    class bytes_writer_bounded
+    {
+    public:
+        bytes_writer_bounded(uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                if (can_write<_Vty>())
+                {
+                    *(_Vty *)(m_data + m_pos) = val;
+
+                    m_pos += sizeof(_Vty);
+                }
+                else
+                {
+                    m_dropped += sizeof(_Vty);
+                }
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            auto _copy_len = (std::min)(length, m_length - m_pos);
+
+            if (_copy_len > 0)
+            {
+                memcpy(m_data + m_pos, data, _copy_len);
+
+                m_pos += _copy_len;
+            }
+
+            m_dropped += length - _copy_len;
+        }
+
+        template <class _Vty>
+        bytes_writer_bounded &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
+        bool can_write() const
+        {
+            return remaining() >= sizeof(_Vty);
+        }
+
+        void reset(uint8_t *data, size_t length)
+        {
+            m_pos = 0;
+            m_dropped = 0;
+            m_data = data;
+            m_length = length;
+        }
+
+        /*
+         * Get the total bytes written
+         */
+        size_t count() const
+        {
+            return m_pos;
+        }
+
+        /*
+         * Get the beginning of the underlying buffer
+         */
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        size_t remaining() const
+        {
+            return m_length - m_pos;
+        }
+
+        /*
+         * Get the bytes that did not fit into the buffer and were dropped
+         */
+        size_t dropped() const
+        {
+            return m_dropped;
+        }
+
+    private:
+        uint8_t *m_data{nullptr};
+        size_t m_pos{0};
+        size_t m_length{0};
+        size_t m_dropped{0};
+    };
+
+    /*
+     * Writer over a buffer that is known to be large enough, e.g. sized by get_size()
+     * It performs no capacity check at all, the caller is responsible for the buffer size
+     */
+    class bytes_writer_unchecked
+    {
+    public:
+        bytes_writer_unchecked(uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                memcpy(m_data + m_pos, std::addressof(val), sizeof(_Vty));
+
+                m_pos += sizeof(_Vty);
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            write(data.data(), data.size());
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            // an empty container may hand in a null `data`
+            if (length != 0)
+                memcpy(m_data + m_pos, data, length);
+
+            m_pos += length;
+        }
+
+        template <class _Vty>
+        bytes_writer_unchecked &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        template <class _Ty>
+        constexpr bool can_write() const
+        {
+            return true;
+        }
+
+        void reset(uint8_t *data, size_t length)
+        {
+            m_pos = 0;
+            m_data = data;
+            m_length = length;
+        }
+
+        /*
+         * Get the total bytes written
+         */
+        size_t count() const
+        {
+            return m_pos;
+        }
+
+        /*
+         * Get the beginning of the underlying buffer
+         */
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        size_t remaining() const
+        {
+            return m_length - m_pos;
+        }
+
+    private:
+        uint8_t *m_data{nullptr};
+        size_t m_pos{0};
+        size_t m_length{0};
+    };
+
+    namespace detail
+    {
+        /*
+         * Incremental checksum fed by a writer or reader
+         * Small pieces are gathered in a staging buffer so the checksum kernels run on blocks
+         */
+        template <class _CheckSum>
+        class checksum_stream
+        {
+        public:
+            static constexpr size_t staging_size = 4096;
+
+            /* block size checksummed at once, small enough for the bytes to still be in cache */
+            static constexpr size_t chunk_size = 32768;
+
+            checksum_stream(const _CheckSum &checksum) : m_checksum(checksum), m_state(checksum.init()) {}
+
+            void update(const uint8_t *data, size_t length)
+            {
+                // an empty container may hand in a null `data`
+                if (length == 0)
+                    return;
+
+                if (length >= staging_size)
+                {
+                    flush();
+
+                    m_checksum.update(m_state, data, length);
+
+                    return;
+                }
+
+                if (m_staged + length > staging_size)
+                    flush();
+
+                memcpy(m_staging + m_staged, data, length);
+
+                m_staged += length;
+            }
+
+            auto finalize()
+            {
+                flush();
+
+                return m_checksum.finalize(m_state);
+            }
+
+        private:
+            void flush()
+            {
+                if (m_staged > 0)
+                {
+                    m_checksum.update(m_state, m_staging, m_staged);
+
+                    m_staged = 0;
+                }
+            }
+
+            const _CheckSum &m_checksum;
+            typename _CheckSum::state_type m_state;
+            size_t m_staged{0};
+            uint8_t m_staging[staging_size];
+        };
+    }
+
+    /*
+     * Writer adaptor that updates a streaming checksum with every byte passed to the underlying writer
+     * When the writer exposes its buffer by data(), the bytes are checksummed there in blocks right after they are written,
+     * otherwise every write is fed to the checksum
+     */
+    template <class _Writer, class _CheckSum>
+    class checksum_writer
+    {
+    public:
+        checksum_writer(_Writer &writer, const _CheckSum &checksum) : m_writer(writer), m_stream(checksum), m_checked(writer.count()) {}
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                if constexpr (_Buffered)
+                {
+                    m_writer.write(val);
+
+                    advance();
+                }
+                else
+                {
+                    if (!m_writer.template can_write<_Vty>())
+                        return;
+
+                    auto begin = reinterpret_cast<const uint8_t *>(std::addressof(val));
+
+                    m_stream.update(begin, sizeof(_Vty));
+
+                    m_writer.write(begin, sizeof(_Vty));
+                }
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            write(data.data(), data.size());
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            if constexpr (_Buffered)
+            {
+                m_writer.write(data, length);
+
+                advance();
+            }
+            else
+            {
+                auto before = m_writer.count();
+
+                m_writer.write(data, length);
+
+                // bounded writers may truncate
+                m_stream.update(data, m_writer.count() - before);
+            }
+        }
+
+        template <class _Vty>
+        checksum_writer &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        template <class _Vty>
+        bool can_write() const
+        {
+            return m_writer.template can_write<_Vty>();
+        }
+
+        /*
+         * Get the total bytes written
+         */
+        size_t count() const
+        {
+            return m_writer.count();
+        }
+
+        size_t remaining() const
+        {
+            return m_writer.remaining();
+        }
+
+        /*
+         * Finish the checksum of everything written so far
+         */
+        auto checksum()
+        {
+            if constexpr (_Buffered)
+                flush();
+
+            return m_stream.finalize();
+        }
+
+    private:
+        static constexpr bool _Buffered = has_buffer_v<_Writer>;
+
+        void advance()
+        {
+            if (m_writer.count() - m_checked >= detail::checksum_stream<_CheckSum>::chunk_size)
+                flush();
+        }
+
+        void flush()
+        {
+            auto count = m_writer.count();
+
+            m_stream.update(m_writer.data() + m_checked, count - m_checked);
+
+            m_checked = count;
+        }
+
+        _Writer &m_writer;
+        detail::checksum_stream<_CheckSum> m_stream;
+        size_t m_checked;
+    };
+
+    /*
+     * Reader adaptor that updates a streaming checksum with every byte consumed from the underlying reader
+     * Only forward seeks are supported, skipped bytes are checksummed as well
+     */
+    template <class _Reader, class _CheckSum>
+    class checksum_reader
+    {
+    public:
+        checksum_reader(_Reader &reader, const _CheckSum &checksum) : m_reader(reader), m_stream(checksum), m_checked(reader.count()) {}
+
+        template <class _Vty>
+        _Vty read()
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                if constexpr (_Buffered)
+                {
+                    auto result = m_reader.template read<_Vty>();
+
+                    advance();
+
+                    return result;
+                }
+                else
+                {
+                    std::remove_cv_t<_Vty> result{};
+
+                    read(reinterpret_cast<uint8_t *>(std::addressof(result)), sizeof(_Vty));
+
+                    return result;
+                }
+            }
+            else
+            {
+                return deserialize_object<_Vty>(*this);
+            }
+        }
+
+        template <class _Vty>
+        checksum_reader &operator>>(_Vty &val)
+        {
+            val = this->read<_Vty>();
+
+            return *this;
+        }
+
+        std::vector<uint8_t> read_bytes(size_t count)
+        {
+            auto result = m_reader.read_bytes(count);
+
+            if constexpr (_Buffered)
+                advance();
+            else
+                m_stream.update(result.data(), result.size());
+
+            return result;
+        }
+
+        /*
+         * Copy `length` bytes out to `data`, nothing is read if there are not enough bytes remaining
+         */
+        bool read(uint8_t *data, size_t length)
+        {
+            if (remaining() < length)
+                return false;
+
+            // large blocks are copied in pieces, so each piece is checksummed while still in cache
+            while (length > 0)
+            {
+                auto piece = (std::min)(length, detail::checksum_stream<_CheckSum>::chunk_size);
+
+                m_reader.read(data, piece);
+
+                if constexpr (_Buffered)
+                    advance();
+                else
+                    m_stream.update(data, piece);
+
+                data += piece;
+                length -= piece;
+            }
+
+            return true;
+        }
+
+        template <class _Vty>
+        bool can_read() const
+        {
+            return m_reader.template can_read<_Vty>();
+        }
+
+        size_t remaining() const
+        {
+            return m_reader.remaining();
+        }
+
+        size_t count() const
+        {
+            return m_reader.count();
+        }
+
+        /*
+         * Get the beginning of the underlying buffer, the bytes viewed from it are checksummed once skipped
+         */
+        template <class _Ty = _Reader>
+        auto data() const -> decltype(std::declval<const _Ty &>().data())
+        {
+            return m_reader.data();
+        }
+
+        void skip(size_t count)
+        {
+            if (remaining() < count)
+                return;
+
+            if constexpr (_Buffered)
+            {
+                m_reader.skip(count);
+
+                advance();
+            }
+            else
+            {
+                uint8_t buffer[256];
+
+                while (count > 0)
+                {
+                    auto piece = (std::min)(count, sizeof(buffer));
+
+                    read(buffer, piece);
+
+                    count -= piece;
+                }
+            }
+        }
+
+        void seek(size_t pos)
+        {
+            if (pos >= count())
+                skip(pos - count());
+        }
+
+        /*
+         * Finish the checksum of everything read so far
+         */
+        auto checksum()
+        {
+            if constexpr (_Buffered)
+                flush();
+
+            return m_stream.finalize();
+        }
+
+    private:
+        static constexpr bool _Buffered = has_buffer_v<_Reader>;
+
+        void advance()
+        {
+            if (m_reader.count() - m_checked >= detail::checksum_stream<_CheckSum>::chunk_size)
+                flush();
+        }
+
+        void flush()
+        {
+            auto count = m_reader.count();
+
+            m_stream.update(m_reader.data() + m_checked, count - m_checked);
+
+            m_checked = count;
+        }
+
+        _Reader &m_reader;
+        detail::checksum_stream<_CheckSum> m_stream;
+        size_t m_checked;
+    };
+
+    namespace detail
+    {
+        /* integers wider than a byte are varint-encoded in compact mode, a single byte gains nothing from it */
+        template <class _Ty>
+        constexpr bool is_varint_v = std::is_integral_v<std::remove_cv_t<_Ty>> && sizeof(_Ty) > 1;
+
+        /* a 64-bit value takes at most 10 groups of 7 bits */
+        constexpr size_t _varint_max_size = 10;
+
+        /* the length in the high nibble of a short header, the lengths from this one up follow as a varint */
+        constexpr uint8_t _short_length_escape = 0x0f;
+
+        /*
+         * Pairs, tuples and PODs carry no sub type, so their compact data_header is a single byte with the length
+         * in the high nibble; the other types keep the type byte and are followed by the length as a varint
+         */
+        constexpr bool has_short_header(uint8_t type)
+        {
+            auto _type = type & 0x0f;
+
+            return _type == d_pod || _type == d_pair || _type == d_tuple;
+        }
+
+        /*
+         * Map a signed value to an unsigned one by zigzag, so that small negative values stay short as well
+         */
+        template <class _Ty>
+        constexpr std::uint64_t zigzag_encode(_Ty value)
+        {
+            if constexpr (std::is_signed_v<_Ty>)
+            {
+                auto _value = static_cast<std::int64_t>(value);
+
+                return (static_cast<std::uint64_t>(_value) << 1) ^ static_cast<std::uint64_t>(_value >> 63);
+            }
+            else
+            {
+                return static_cast<std::uint64_t>(value);
+            }
+        }
+
+        template <class _Ty>
+        constexpr _Ty zigzag_decode(std::uint64_t value)
+        {
+            if constexpr (std::is_signed_v<_Ty>)
+                return static_cast<_Ty>(static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1)));
+            else
+                return static_cast<_Ty>(value);
+        }
+
+        /*
+         * Write `value` as a LEB128 varint, return the number of bytes written
+         */
+        inline size_t write_varint(uint8_t *data, std::uint64_t value)
+        {
+            size_t size = 0;
+
+            for (; value >= 0x80; value >>= 7)
+                data[size++] = static_cast<uint8_t>(value) | 0x80;
+
+            data[size++] = static_cast<uint8_t>(value);
+
+            return size;
+        }
+
+        /*
+         * Read a varint from the `length` bytes at `data` one byte at a time
+         * Return the size of the varint, or 0 if it is truncated or longer than _varint_max_size
+         */
+        inline size_t read_varint_slow(const uint8_t *data, size_t length, std::uint64_t &value)
+        {
+            value = 0;
+
+            length = (std::min)(length, _varint_max_size);
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                value |= static_cast<std::uint64_t>(data[i] & 0x7f) << (7 * i);
+
+                if ((data[i] & 0x80) == 0)
+                    return i + 1;
+            }
+
+            return 0;
+        }
+
+        /*
+         * Read a varint with at least _varint_max_size bytes readable at `data`
+         * Varints of up to 8 bytes, values below 2^56, are decoded from a single load: the first byte with a clear
+         * high bit ends the varint, and its 7-bit groups are packed together by three mask and shift steps
+         */
+        inline size_t read_varint(const uint8_t *data, std::uint64_t &value)
+        {
+            std::uint64_t word{};
+
+            memcpy(&word, data, sizeof(word));
+
+            auto stop = ~word & 0x8080808080808080ULL;
+
+            if (stop == 0)
+                return read_varint_slow(data, _varint_max_size, value);
+
+            // keep the bytes up to the last one of the varint
+            word &= stop ^ (stop - 1);
+
+            word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+            word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+            word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+
+            value = word;
+
+            return trailing_zero_bytes(stop) + 1;
+        }
+    }
+
+    /*
+     * Writer adaptor of the compact wire format: the length of every data_header and integers wider than a byte
+     * are written as LEB128 varints, signed integers zigzag-encoded first, the headers of pairs, tuples and small PODs
+     * take one byte, see detail::has_short_header. Other values are passed through unchanged
+     * Containers of integers are written element by element instead of as a block, indexed is not supported
+     */
+    template <class _Writer>
+    class compact_writer
+    {
+    public:
+        compact_writer(_Writer &writer) : m_writer(writer) {}
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (std::is_same_v<_Vty, data_header>)
+            {
+                uint8_t buffer[1 + detail::_varint_max_size];
+
+                size_t size = 1;
+
+                if (!detail::has_short_header(val.type))
+                {
+                    buffer[0] = val.type;
+
+                    size += detail::write_varint(buffer + 1, val.length);
+                }
+                else if (val.length < detail::_short_length_escape)
+                {
+                    buffer[0] = static_cast<uint8_t>((val.type & 0x0f) | val.length << 4);
+                }
+                else
+                {
+                    buffer[0] = static_cast<uint8_t>((val.type & 0x0f) | detail::_short_length_escape << 4);
+
+                    size += detail::write_varint(buffer + 1, val.length);
+                }
+
+                m_writer.write(buffer, size);
+            }
+            else if constexpr (detail::is_varint_v<_Vty>)
+            {
+                uint8_t buffer[detail::_varint_max_size];
+
+                m_writer.write(buffer, detail::write_varint(buffer, detail::zigzag_encode(val)));
+            }
+            else if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                m_writer.write(val);
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            m_writer.write(data);
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            m_writer.write(data, length);
+        }
+
+        template <class _Vty>
+        compact_writer &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        /*
+         * A varint takes at least one byte, whether a long one fits is only known once it is encoded
+         */
+        template <class _Vty>
+        bool can_write() const
+        {
+            if constexpr (std::is_same_v<_Vty, data_header> || detail::is_varint_v<_Vty>)
+                return m_writer.template can_write<uint8_t>();
+            else
+                return m_writer.template can_write<_Vty>();
+        }
+
+        size_t count() const
+        {
+            return m_writer.count();
+        }
+
+        size_t remaining() const
+        {
+            return m_writer.remaining();
+        }
+
+    private:
+        _Writer &m_writer;
+    };
+
+    /*
+     * Reader adaptor of the compact wire format written by compact_writer
+     * When the reader exposes its buffer by data(), varints are decoded in place, see detail::read_varint
+     */
+    template <class _Reader>
+    class compact_reader
+    {
+    public:
+        compact_reader(_Reader &reader) : m_reader(reader) {}
+
+        template <class _Vty>
+        _Vty read()
+        {
+            if constexpr (std::is_same_v<std::remove_cv_t<_Vty>, data_header>)
+            {
+                data_header header{};
+
+                header.type = m_reader.template read<uint8_t>();
+
+                if (detail::has_short_header(header.type))
+                {
+                    uint8_t length = header.type >> 4;
+
+                    header.type &= 0x0f;
+                    header.length = length < detail::_short_length_escape ? length : static_cast<std::uint32_t>(read_varint());
+                }
+                else
+                {
+                    header.length = static_cast<std::uint32_t>(read_varint());
+                }
+
+                return header;
+            }
+            else if constexpr (detail::is_varint_v<_Vty>)
+            {
+                return detail::zigzag_decode<std::remove_cv_t<_Vty>>(read_varint());
+            }
+            else if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                return m_reader.template read<_Vty>();
+            }
+            else
+            {
+                return deserialize_object<_Vty>(*this);
+            }
+        }
+
+        template <class _Vty>
+        compact_reader &operator>>(_Vty &val)
+        {
+            val = this->read<_Vty>();
+
+            return *this;
+        }
+
+        std::vector<uint8_t> read_bytes(size_t count)
+        {
+            return m_reader.read_bytes(count);
+        }
+
+        bool read(uint8_t *data, size_t length)
+        {
+            return m_reader.read(data, length);
+        }
+
+        template <class _Vty>
+        bool can_read() const
+        {
+            if constexpr (std::is_same_v<std::remove_cv_t<_Vty>, data_header> || detail::is_varint_v<_Vty>)
+                return m_reader.template can_read<uint8_t>();
+            else
+                return m_reader.template can_read<_Vty>();
+        }
+
+        size_t remaining() const
+        {
+            return m_reader.remaining();
+        }
+
+        size_t count() const
+        {
+            return m_reader.count();
+        }
+
+        template <class _Ty = _Reader>
+        auto data() const -> decltype(std::declval<const _Ty &>().data())
+        {
+            return m_reader.data();
+        }
+
+        void skip(size_t count)
+        {
+            m_reader.skip(count);
+        }
+
+        void seek(size_t pos)
+        {
+            m_reader.seek(pos);
+        }
+
+    private:
+        /* a malformed varint consumes the rest of the data, so the reads after it come out empty */
+        std::uint64_t read_varint()
+        {
+            std::uint64_t value{};
+
+            if constexpr (has_buffer_v<_Reader>)
+            {
+                auto data = m_reader.data() + m_reader.count();
+
+                auto size = m_reader.remaining() >= detail::_varint_max_size
+                                ? detail::read_varint(data, value)
+                                : detail::read_varint_slow(data, m_reader.remaining(), value);
+
+                if (size != 0)
+                {
+                    m_reader.skip(size);
+
+                    return value;
+                }
+            }
+            else
+            {
+                for (unsigned shift = 0; shift < 7 * detail::_varint_max_size && m_reader.template can_read<uint8_t>(); shift += 7)
+                {
+                    auto byte = m_reader.template read<uint8_t>();
+
+                    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+                    if ((byte & 0x80) == 0)
+                        return value;
+                }
+            }
+
+            m_reader.skip(m_reader.remaining());
+
+            return 0;
+        }
+
+        _Reader &m_reader;
+    };
+
+    template <class _Ty>
+    struct is_compact : std::false_type
+    {
+    };
+
+    template <class _Writer>
+    struct is_compact<compact_writer<_Writer>> : std::true_type
+    {
+    };
+
+    template <class _Reader>
+    struct is_compact<compact_reader<_Reader>> : std::true_type
+    {
+    };
+
+    /* a writer or reader of the compact wire format */
+    template <class _Ty>
+    constexpr bool is_compact_v = is_compact<remove_cvref_t<_Ty>>::value;
+
+    namespace detail
+    {
+        /* `_Ty` is not stored as raw bytes by the writer or reader `_Stream`, so blocks of it can not be copied at once */
+        template <class _Stream, class _Ty>
+        constexpr bool varint_encoded_v = is_compact_v<_Stream> && is_varint_v<_Ty>;
+    }
+
+    template <class _Ty>
+    constexpr size_t get_size(const _Ty &);
+
+    template <class _Ty>
+    constexpr void get_object_size(const _Ty &, size_t &);
+
+    namespace detail
+    {
+        /*
+         * Nested values are written by `writer << v`, which stores trivially copyable values as raw bytes,
+         * so their size never includes a data_header
+         */
+        template <class _Ty>
+        constexpr void get_element_size(const _Ty &object, size_t &size)
+        {
+            if constexpr (is_trivially_serializable_v<_Ty>)
+                size += sizeof(_Ty);
+            else
+                get_object_size(object, size);
+        }
+
+        template <class _Variant, size_t... _Indices>
+        constexpr size_t get_variant_size_impl(const _Variant &variant, std::index_sequence<_Indices...>)
+        {
+            using _Get_variant_size_t = size_t (*)(const _Variant &);
+
+            constexpr _Get_variant_size_t _table[] =
+                {
+                    [](const _Variant &variant) -> size_t
+                    {
+                        size_t size{};
+
+                        get_element_size(std::get<_Indices>(variant), size);
+
+                        return size;
+                    }...};
+
+            return _table[variant.index()](variant);
+        }
+
+        template <class _Tuple, size_t... _Indices>
+        constexpr size_t get_tuple_size_impl(const _Tuple &tuple, std::index_sequence<_Indices...>)
+        {
+            size_t size{};
+
+            (get_element_size(std::get<_Indices>(tuple), size), ...);
+
+            return size;
+        }
+
+        template <class _Tuple, class _Writer, size_t... _Indices>
+        void serialize_tuple_impl(_Writer &writer, const _Tuple &tuple, std::index_sequence<_Indices...>)
+        {
+            (writer << ... << std::get<_Indices>(tuple));
+        }
+
+        /*
+         * The fewest bytes an element of _Ty occupies in the serialized data, used to bound
+         * the capacity reserved from an untrusted element count
+         * A custom serialize() may write nothing at all, so such elements are not bounded
+         */
+        template <class _Ty>
+        constexpr size_t min_element_size()
+        {
+            if constexpr (is_trivially_serializable_v<_Ty>)
+                return sizeof(_Ty);
+            else if constexpr (has_deserialize_v<_Ty>)
+                return 0;
+            else
+                return sizeof(data_header);
+        }
+
+        /*
+         * Size of the data_header of a container of `length` elements
+         */
+        constexpr size_t container_header_size(size_t length)
+        {
+            return length < _large_length ? sizeof(data_header) : sizeof(data_header) + sizeof(std::uint64_t);
+        }
+
+        /*
+         * Write the data_header of a container of `length` elements, a count that does not fit in data_header::length
+         * follows the header as a std::uint64_t, see _large_length
+         */
+        template <class _Writer>
+        void write_container_header(_Writer &writer, data_header header, size_t length)
+        {
+            if (length < _large_length)
+            {
+                header.length = static_cast<std::uint32_t>(length);
+
+                writer << header;
+            }
+            else
+            {
+                header.length = _large_length;
+
+                writer << header << static_cast<std::uint64_t>(length);
+            }
+        }
+
+        /*
+         * Read the element count of the container whose data_header was just read
+         */
+        template <class _Reader>
+        size_t read_container_length(_Reader &reader, const data_header &header)
+        {
+            if (header.length != _large_length)
+                return header.length;
+
+            auto length = reader.template read<std::uint64_t>();
+
+            // runtime check, the count is bounded by the elements read, see fits_remaining()
+            if (length > (std::numeric_limits<size_t>::max)())
+                return 0;
+
+            return static_cast<size_t>(length);
+        }
+
+        /*
+         * The fewest bytes an element of _Ty occupies in the data read by _Reader,
+         * an element may be a single varint byte in compact mode
+         */
+        template <class _Ty, class _Reader>
+        constexpr size_t min_encoded_size()
+        {
+            return is_compact_v<_Reader> ? (std::min)(size_t{1}, min_element_size<_Ty>()) : min_element_size<_Ty>();
+        }
+
+        /*
+         * Whether `length` elements of _Ty can be in the bytes left in `reader`, a bogus count is rejected before any element is read
+         */
+        template <class _Ty, class _Reader>
+        bool fits_remaining(size_t length, const _Reader &reader)
+        {
+            constexpr auto _size = min_encoded_size<_Ty, _Reader>();
+
+            return _size == 0 || length <= reader.remaining() / _size;
+        }
+
+        template <class _Ty, class _Reader>
+        void reserve_elements(_Ty &container, size_t length, const _Reader &reader)
+        {
+            using value_type = typename _Ty::value_type;
+
+            if constexpr (has_reserve_v<_Ty>)
+            {
+                container.reserve((std::min)(length, reader.remaining() / (std::max)(min_encoded_size<value_type, _Reader>(), size_t{1})));
+            }
+        }
+
+        /*
+         * Read a sequence of trivially copyable elements as a view into the reader's buffer, nothing is copied
+         * The view is only valid as long as the buffer, and its elements may not be aligned
+         */
+        template <class _View, class _Reader>
+        _View read_view(_Reader &reader)
+        {
+            using value_type = typename _View::value_type;
+
+            static_assert(std::is_trivially_copyable_v<value_type>, "only sequences of trivially copyable elements can be viewed");
+            static_assert(!varint_encoded_v<_Reader, value_type>, "integers are varint-encoded in compact mode and can not be viewed");
+
+            auto _header = reader.template read<data_header>();
+
+            // runtime check
+            if (_header.get_main_type() != d_seq_container || !_header.template is_subtype_compitable<value_type>())
+                return _View{};
+
+            auto _length = read_container_length(reader, _header);
+
+            // runtime check
+            if (_length > reader.remaining() / sizeof(value_type))
+                return _View{};
+
+            auto _bytes = _length * sizeof(value_type);
+
+            auto _data = reinterpret_cast<const value_type *>(reader.data() + reader.count());
+
+            reader.skip(_bytes);
+
+            return _View{_data, _length};
+        }
+
+        /*
+         * Size of an offset of the table of the indexed container whose data_header is `header`, see _large_length
+         */
+        constexpr size_t index_offset_size(const data_header &header)
+        {
+            return header.length == _large_length ? sizeof(std::uint64_t) : sizeof(std::uint32_t);
+        }
+
+        /*
+         * Skip the offset table of an indexed container of `length` elements, returns the container type stored
+         * in front of it or d_empty if the table is truncated
+         */
+        template <class _Reader>
+        data_type skip_index(_Reader &reader, const data_header &header, size_t length)
+        {
+            auto _type = static_cast<data_type>(reader.template read<uint8_t>());
+
+            // runtime check
+            if (length >= reader.remaining() / index_offset_size(header))
+                return d_empty;
+
+            auto _bytes = (length + 1) * index_offset_size(header);
+
+            reader.skip(_bytes);
+
+            return _type;
+        }
+
+        template <class _Ty>
+        struct delta_key_type
+        {
+            using type = _Ty;
+        };
+
+        template <class _Ty1, class _Ty2>
+        struct delta_key_type<std::pair<_Ty1, _Ty2>>
+        {
+            using type = std::remove_cv_t<_Ty1>;
+        };
+
+        /* the integer a delta is taken of, the element itself or the key of a map */
+        template <class _Ty>
+        using delta_key_t = typename delta_key_type<std::remove_cv_t<_Ty>>::type;
+
+        template <class _Ty>
+        constexpr const _Ty &delta_key(const _Ty &value)
+        {
+            return value;
+        }
+
+        template <class _Ty1, class _Ty2>
+        constexpr const _Ty1 &delta_key(const std::pair<_Ty1, _Ty2> &value)
+        {
+            return value.first;
+        }
+
+        template <class _Ty>
+        auto has_key_compare_impl(int) -> decltype(std::declval<typename _Ty::key_compare>(), std::true_type{});
+
+        template <class _Ty>
+        std::false_type has_key_compare_impl(...);
+
+        template <class _Ty>
+        constexpr bool is_delta_key_v = std::is_integral_v<_Ty> && !std::is_same_v<_Ty, bool>;
+
+        /*
+         * Sequence containers of integers and ordered association containers with integer keys,
+         * the keys of the latter come out sorted so their deltas stay small
+         */
+        template <class _Ty>
+        constexpr bool is_delta_encodable_impl()
+        {
+            if constexpr (is_sequence_container_v<_Ty>)
+                return is_delta_key_v<typename _Ty::value_type>;
+            else if constexpr (is_associated_container_v<_Ty> && decltype(has_key_compare_impl<_Ty>(0))::value)
+                return is_delta_key_v<delta_key_t<typename _Ty::value_type>>;
+            else
+                return false;
+        }
+
+        template <class _Ty>
+        constexpr bool is_delta_encodable_v = is_delta_encodable_impl<std::remove_cv_t<_Ty>>();
+
+        /*
+         * The zigzag-encoded difference of two consecutive keys, taken in the unsigned type so that it wraps
+         * instead of overflowing, see delta_value
+         */
+        template <class _Ty>
+        constexpr std::uint64_t delta_of(_Ty previous, _Ty value)
+        {
+            using _Unsigned = std::make_unsigned_t<_Ty>;
+
+            return zigzag_encode(static_cast<std::make_signed_t<_Ty>>(static_cast<_Unsigned>(static_cast<_Unsigned>(value) - static_cast<_Unsigned>(previous))));
+        }
+
+        inline size_t varint_size(std::uint64_t value)
+        {
+            size_t size = 1;
+
+            for (; value >= 0x80; value >>= 7)
+                ++size;
+
+            return size;
+        }
+
+#ifdef ZPACKER_SIMD
+        template <class _Ty>
+        ZPACKER_TARGET("sse2")
+        inline __m128i broadcast_lanes(_Ty value)
+        {
+            if constexpr (sizeof(_Ty) == 1)
+                return _mm_set1_epi8(static_cast<char>(value));
+            else if constexpr (sizeof(_Ty) == 2)
+                return _mm_set1_epi16(static_cast<short>(value));
+            else if constexpr (sizeof(_Ty) == 4)
+                return _mm_set1_epi32(static_cast<int>(value));
+            else
+                return _mm_set1_epi64x(static_cast<long long>(value));
+        }
+
+        template <class _Ty>
+        ZPACKER_TARGET("sse2")
+        inline __m128i add_lanes(__m128i left, __m128i right)
+        {
+            if constexpr (sizeof(_Ty) == 1)
+                return _mm_add_epi8(left, right);
+            else if constexpr (sizeof(_Ty) == 2)
+                return _mm_add_epi16(left, right);
+            else if constexpr (sizeof(_Ty) == 4)
+                return _mm_add_epi32(left, right);
+            else
+                return _mm_add_epi64(left, right);
+        }
+
+        /*
+         * Prefix sum of a register at a time: every lane is added to the ones above it by log2(lanes) shifted adds,
+         * then the running total of the previous registers is added to all the lanes
+         */
+        template <class _Ty>
+        ZPACKER_TARGET("sse2")
+        inline size_t prefix_sum_sse2(_Ty *data, size_t count, _Ty &sum)
+        {
+            constexpr size_t _Lanes = 16 / sizeof(_Ty);
+
+            auto carry = broadcast_lanes(sum);
+
+            size_t i = 0;
+
+            for (; i + _Lanes <= count; i += _Lanes)
+            {
+                auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+                if constexpr (sizeof(_Ty) == 1)
+                    x = add_lanes<_Ty>(x, _mm_slli_si128(x, 1));
+
+                if constexpr (sizeof(_Ty) <= 2)
+                    x = add_lanes<_Ty>(x, _mm_slli_si128(x, 2));
+
+                if constexpr (sizeof(_Ty) <= 4)
+                    x = add_lanes<_Ty>(x, _mm_slli_si128(x, 4));
+
+                x = add_lanes<_Ty>(add_lanes<_Ty>(x, _mm_slli_si128(x, 8)), carry);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), x);
+
+                carry = broadcast_lanes(data[i + _Lanes - 1]);
+            }
+
+            if (i != 0)
+                sum = data[i - 1];
+
+            return i;
+        }
+#endif
+
+        /*
+         * Replace the deltas at `data` by the values they lead to from `sum`, return the last value
+         */
+        template <class _Ty>
+        _Ty prefix_sum(_Ty *data, size_t count, _Ty sum)
+        {
+            static_assert(std::is_unsigned_v<_Ty>, "deltas are summed as unsigned integers so that they wrap");
+
+            size_t i = 0;
+
+#ifdef ZPACKER_SIMD
+            i = prefix_sum_sse2(data, count, sum);
+#endif
+            for (; i < count; ++i)
+                data[i] = sum = static_cast<_Ty>(sum + data[i]);
+
+            return sum;
+        }
+
+        /*
+         * Decode `count` varint deltas from the `length` bytes at `data` into `out`, then turn them into values
+         * continuing from `sum`, which is updated to the last one
+         * Return the number of bytes read, or 0 if the deltas are truncated or malformed
+         */
+        template <class _Ty>
+        size_t read_deltas(const uint8_t *data, size_t length, _Ty *out, size_t count, _Ty &sum)
+        {
+            auto _data = data;
+            auto _end = data + length;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::uint64_t value{};
+
+                auto size = static_cast<size_t>(_end - _data) >= _varint_max_size
+                                ? read_varint(_data, value)
+                                : read_varint_slow(_data, static_cast<size_t>(_end - _data), value);
+
+                if (size == 0)
+                    return 0;
+
+                _data += size;
+
+                out[i] = static_cast<_Ty>(zigzag_decode<std::make_signed_t<_Ty>>(value));
+            }
+
+            sum = prefix_sum(out, count, sum);
+
+            return static_cast<size_t>(_data - data);
+        }
+
+        /* deltas are decoded and summed this many at a time, so a block is still in cache when it is summed */
+        constexpr size_t _delta_block = 4096;
+
+        /*
+         * Read a container written by delta_encoded, its data_header is already read
+         * Containers that can not hold the keys come out empty
+         */
+        template <class _Ty, class _Reader>
+        _Ty read_delta(_Reader &reader, data_header header)
+        {
+            _Ty container{};
+
+            if constexpr (is_delta_encodable_v<_Ty>)
+            {
+                using value_type = typename _Ty::value_type;
+                using key_type = delta_key_t<value_type>;
+                using _Unsigned = std::make_unsigned_t<key_type>;
+
+                auto _length = read_container_length(reader, header);
+                auto _container_type = reader.template read<uint8_t>();
+                auto _key_type = reader.template read<uint8_t>();
+                auto _bytes = reader.template read<std::uint64_t>();
+
+                // runtime check, every delta takes at least a byte
+                if (_container_type != get_data_type<_Ty>() || _key_type != get_data_type<key_type>() ||
+                    !header.template is_subtype_compitable<value_type>() || _bytes > reader.remaining() || _length > _bytes)
+                    return container;
+
+                const uint8_t *_data{};
+
+                std::vector<uint8_t> _buffer{};
+
+                if constexpr (has_buffer_v<_Reader>)
+                {
+                    _data = reader.data() + reader.count();
+
+                    reader.skip(static_cast<size_t>(_bytes));
+                }
+                else
+                {
+                    _buffer = reader.read_bytes(static_cast<size_t>(_bytes));
+
+                    // runtime check, remaining() of a streaming reader is not exact until its source ends
+                    if (_buffer.size() != _bytes)
+                        return container;
+
+                    _data = _buffer.data();
+                }
+
+                size_t _read{};
+
+                _Unsigned _sum{};
+
+                if constexpr (is_contiguous_container_v<_Ty> && has_resize_v<_Ty>)
+                {
+                    container.resize(_length);
+
+                    /* the values are rebuilt in place, the elements have the layout of the unsigned deltas */
+                    auto _out = reinterpret_cast<_Unsigned *>(container.data());
+
+                    for (size_t i = 0; i < _length; i += _delta_block)
+                    {
+                        auto _count = (std::min)(_delta_block, _length - i);
+                        auto _size = read_deltas(_data + _read, static_cast<size_t>(_bytes) - _read, _out + i, _count, _sum);
+
+                        // runtime check
+                        if (_size == 0)
+                            return _Ty{};
+
+                        _read += _size;
+                    }
+                }
+                else
+                {
+                    std::vector<_Unsigned> _block((std::min)(_delta_block, _length));
+
+                    detail::reserve_elements(container, _length, reader);
+
+                    for (size_t i = 0; i < _length; i += _delta_block)
+                    {
+                        auto _count = (std::min)(_delta_block, _length - i);
+                        auto _size = read_deltas(_data + _read, static_cast<size_t>(_bytes) - _read, _block.data(), _count, _sum);
+
+                        // runtime check
+                        if (_size == 0)
+                            return _Ty{};
+
+                        _read += _size;
+
+                        for (size_t j = 0; j < _count; ++j)
+                        {
+                            auto _key = static_cast<key_type>(_block[j]);
+
+                            if constexpr (is_sequence_container_v<_Ty>)
+                                container.push_back(_key);
+                            else if constexpr (std::is_same_v<value_type, key_type>)
+                                container.emplace_hint(container.end(), _key);
+                            else
+                                container.emplace_hint(container.end(), _key, reader.template read<typename _Ty::mapped_type>());
+                        }
+                    }
+                }
+
+                // runtime check
+                if (_read != _bytes)
+                    return _Ty{};
+            }
+
+            return container;
+        }
+
+        template <class _Ty>
+        constexpr bool is_columnar_impl()
+        {
+            if constexpr ((is_sequence_container_v<_Ty> || is_associated_container_v<_Ty>) &&
+                          is_specialize_of_v<typename _Ty::value_type, std::pair>)
+                return is_trivially_serializable_v<std::remove_cv_t<typename _Ty::value_type::first_type>> &&
+                       is_trivially_serializable_v<typename _Ty::value_type::second_type>;
+            else
+                return false;
+        }
+
+        /* containers of pairs whose members are stored as their raw bytes, such as std::map<uint64_t, double> */
+        template <class _Ty>
+        constexpr bool is_columnar_v = is_columnar_impl<std::remove_cv_t<_Ty>>();
+
+        /*
+         * Read a column of `length` values, return where it starts or nullptr if it is truncated
+         * The column is used in place when the reader exposes its buffer, otherwise it is copied into `buffer`
+         */
+        template <class _Ty, class _Reader>
+        const uint8_t *read_column(_Reader &reader, size_t length, std::vector<uint8_t> &buffer)
+        {
+            auto _bytes = length * sizeof(_Ty);
+
+            if constexpr (varint_encoded_v<_Reader, _Ty>)
+            {
+                buffer.resize(_bytes);
+
+                for (size_t i = 0; i < length; ++i)
+                {
+                    auto _value = reader.template read<_Ty>();
+
+                    memcpy(buffer.data() + i * sizeof(_Ty), &_value, sizeof(_Ty));
+                }
+
+                return buffer.data();
+            }
+            else if constexpr (has_buffer_v<_Reader>)
+            {
+                // runtime check
+                if (_bytes > reader.remaining())
+                    return nullptr;
+
+                auto _data = reader.data() + reader.count();
+
+                reader.skip(_bytes);
+
+                return _data;
+            }
+            else
+            {
+                buffer.resize(_bytes);
+
+                return reader.read(buffer.data(), _bytes) ? buffer.data() : nullptr;
+            }
+        }
+
+        /*
+         * Read a container written by columnar, its data_header is already read
+         * Containers of other elements come out empty
+         */
+        template <class _Ty, class _Reader>
+        _Ty read_columns(_Reader &reader, const data_header &header)
+        {
+            _Ty container{};
+
+            if constexpr (is_columnar_v<_Ty>)
+            {
+                using value_type = typename _Ty::value_type;
+                using first_type = std::remove_cv_t<typename value_type::first_type>;
+                using second_type = typename value_type::second_type;
+
+                /* a value may be a single varint byte in compact mode */
+                constexpr size_t _min_size = is_compact_v<_Reader> ? 2 : sizeof(first_type) + sizeof(second_type);
+
+                auto _length = read_container_length(reader, header);
+                auto _container_type = reader.template read<uint8_t>();
+
+                // runtime check
+                if (_container_type != get_data_type<_Ty>() || _length > reader.remaining() / _min_size)
+                    return container;
+
+                std::vector<uint8_t> _first_buffer{}, _second_buffer{};
+
+                auto _first = read_column<first_type>(reader, _length, _first_buffer);
+                auto _second = read_column<second_type>(reader, _length, _second_buffer);
+
+                // runtime check
+                if (_first == nullptr || _second == nullptr)
+                    return container;
+
+                if constexpr (has_reserve_v<_Ty>)
+                    container.reserve(_length);
+
+                for (size_t i = 0; i < _length; ++i)
+                {
+                    first_type _key;
+                    second_type _value;
+
+                    memcpy(&_key, _first + i * sizeof(first_type), sizeof(first_type));
+                    memcpy(&_value, _second + i * sizeof(second_type), sizeof(second_type));
+
+                    if constexpr (is_sequence_container_v<_Ty>)
+                        container.push_back(value_type{_key, _value});
+                    else
+                        container.emplace_hint(container.end(), _key, _value);
+                }
+            }
+
+            return container;
+        }
+
+        template <class _Variant, class _Reader, size_t... _Indices>
+        _Variant deserialize_variant_impl(_Reader &reader, uint32_t index, std::index_sequence<_Indices...>)
+        {
+            using _Variant_deserializer_t = _Variant (*)(_Reader &);
+
+            constexpr _Variant_deserializer_t _table[] =
+                {
+                    [](_Reader &reader) -> _Variant
+                    {
+                        using value_type = std::variant_alternative_t<_Indices, _Variant>;
+
+                        return _Variant{reader.template read<value_type>()};
+                    }...};
+
+            return _table[index](reader);
+        }
+
+        template <class _Tuple, class _Reader, size_t... _Indices>
+        _Tuple deserialize_tuple_impl(_Reader &reader, std::index_sequence<_Indices...>)
+        {
+            _Tuple __t{};
+
+            (reader >> ... >> std::get<_Indices>(__t));
+
+            return __t;
+        }
+    }
+
+    template <class _Ty>
+    constexpr void get_object_size(const _Ty &object, size_t &size)
+    {
+        constexpr size_t header_size = sizeof(data_header);
+
+        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be serialized can not be pointer type");
+
+        if constexpr (has_get_size_v<_Ty>)
+        {
+            size += object.get_size();
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::pair>)
+        {
+            size += sizeof(data_header);
+
+            detail::get_element_size(object.first, size);
+            detail::get_element_size(object.second, size);
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::variant>)
+        {
+            using _Variant = remove_cvref_t<_Ty>;
+
+            size += sizeof(data_header) + sizeof(std::uint32_t);
+
+            size += detail::get_variant_size_impl(object, std::make_index_sequence<std::variant_size_v<_Variant>>{});
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::tuple>)
+        {
+            using _Tuple = remove_cvref_t<_Ty>;
+
+            size += sizeof(data_header);
+
+            size += detail::get_tuple_size_impl(object, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+        }
+        else if constexpr (is_standard_container_v<remove_cvref_t<_Ty>>)
+        {
+            using value_type = typename remove_cvref_t<_Ty>::value_type;
+
+            size += detail::container_header_size(object.size());
+
+            /* with this constexpr, compiler can generate more efficient code */
+            if constexpr (is_trivially_serializable_v<value_type>)
+            {
+                size += sizeof(value_type) * object.size();
+            }
+            else
+            {
+                std::for_each(object.begin(), object.end(), [&size](auto &v)
+                              { detail::get_element_size(v, size); });
+            }
+        }
+        else if constexpr (has_iterator_v<remove_cvref_t<_Ty>> && has_value_type_v<remove_cvref_t<_Ty>>)
+        {
+            using value_type = typename remove_cvref_t<_Ty>::value_type;
+
+            auto _count = static_cast<size_t>(std::distance(object.begin(), object.end()));
+
+            size += detail::container_header_size(_count);
+
+            if constexpr (is_trivially_serializable_v<value_type>)
+            {
+                size += sizeof(value_type) * _count;
+            }
+            else
+            {
+                std::for_each(object.begin(), object.end(), [&size](auto &v)
+                              { detail::get_element_size(v, size); });
+            }
+        }
+        else if constexpr (std::is_trivially_copyable_v<remove_cvref_t<_Ty>>)
+        {
+            if constexpr (std::is_compound_v<_Ty>)
+            {
+                size += header_size;
+            }
+
+            size += sizeof(_Ty);
+        }
+        else
+        {
+            static_assert(
+                Always_false<_Ty>,
+                "_Ty must implement \"size_t _Ty::get_size() const\"");
+        }
+    }
+
+    /*
+     * Calculate the memory space size needed for serialization / deserialization of the object
+     */
+    template <class _Ty>
+    constexpr size_t get_size(const _Ty &object)
+    {
+        size_t result{};
+
+        get_object_size(object, result);
+
+        return result;
+    }
+
+    /*
+     * Serialize a object to binary format
+     */
+    template <class _Ty, class _Writer = bytes_writer>
+    void serialize_object(_Writer &writer, const _Ty &object)
+    {
+        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be serialized can not be pointer type");
+
+        if constexpr (has_serialize_v<_Ty>)
+        {
+            object.serialize(writer);
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::pair>)
+        {
+            data_header _header{d_pair, 2};
+
+            writer << _header;
+
+            using _first_type = typename remove_cvref_t<_Ty>::first_type;
+            using _second_type = typename remove_cvref_t<_Ty>::second_type;
+
+            writer << object.first;
+            writer << object.second;
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::variant>)
+        {
+            using _Variant = remove_cvref_t<_Ty>;
+
+            data_header _header{d_variant, std::variant_size_v<_Variant>};
+
+            std::visit([&_header, &writer, &object](auto &&val)
+                       {
+				using value_type = std::decay_t<decltype(val)>;
+
+				_header.set_sub_type(get_data_type<value_type>());
+
+				writer << _header << static_cast<uint32_t>(object.index()) << val; }, object);
+        }
+        else if constexpr (is_specialize_of_v<remove_cvref_t<_Ty>, std::tuple>)
+        {
+            using _Tuple = remove_cvref_t<_Ty>;
+
+            writer << data_header{d_tuple, std::tuple_size_v<_Tuple>};
+
+            detail::serialize_tuple_impl(writer, object, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+        }
+        else if constexpr (is_standard_container_v<remove_cvref_t<_Ty>>)
+        {
+            using container_type = remove_cvref_t<_Ty>;
+            using value_type = typename container_type::value_type;
+
+            data_header _header{};
+
+            if constexpr (is_sequence_container_v<container_type>)
+            {
+                _header.set_main_type(d_seq_container);
+                _header.set_sub_type(get_data_type<value_type>());
+            }
+            else if constexpr (is_associated_container_v<container_type>)
+            {
+                _header.set_main_type(d_aso_container);
+                _header.set_sub_type(get_data_type<value_type>());
+            }
+            /* std::array, std::initializer_list, etc. */
+            else
+            {
+                _header.set_main_type(d_seq_container);
+                _header.set_sub_type(get_data_type<value_type>());
+            }
+
+            detail::write_container_header(writer, _header, object.size());
+
+            /* elements are stored as raw bytes, so the whole block can be copied at once */
+            if constexpr (is_contiguous_container_v<container_type> && is_trivially_serializable_v<value_type> &&
+                          !detail::varint_encoded_v<_Writer, value_type>)
+            {
+                writer.write(reinterpret_cast<const uint8_t *>(object.data()), object.size() * sizeof(value_type));
+            }
+            else
+            {
+                std::for_each(object.begin(), object.end(), [&writer](auto &v)
+                              { writer << v; });
+            }
+        }
+        /* std::forward_list goes here */
+        else if constexpr (has_iterator_v<remove_cvref_t<_Ty>> && has_value_type_v<remove_cvref_t<_Ty>>)
+        {
+            using container_type = remove_cvref_t<_Ty>;
+            using value_type = typename container_type::value_type;
+
+            data_header _header{};
+
+            _header.set_main_type(d_seq_container);
+            _header.set_sub_type(get_data_type<value_type>());
+
+            if constexpr (has_size_v<container_type>)
+            {
+                detail::write_container_header(writer, _header, object.size());
+
+                std::for_each(object.begin(), object.end(), [&writer](auto &v)
+                              { writer << v; });
+            }
+            /* the elements are counted by a pass over the container, so nothing is buffered and the writer may be a stream */
+            else if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<typename container_type::const_iterator>::iterator_category>)
+            {
+                detail::write_container_header(writer, _header, static_cast<size_t>(std::distance(object.begin(), object.end())));
+
+                std::for_each(object.begin(), object.end(), [&writer](auto &v)
+                              { writer << v; });
+            }
+            else
+            {
+                size_t _size{0};
+                std::vector<uint8_t> _partial;
+
+                _partial.reserve(_default_reserve_size);
+
+                bytes_writer _writer{_partial};
+
+                auto _append = [&object, &_size](auto &_to)
+                {
+                    std::for_each(object.begin(), object.end(), [&_to, &_size](auto &v)
+                                  {
+					_to << v;
+					++_size; });
+                };
+
+                /* the elements are buffered in the wire format of `writer` */
+                if constexpr (is_compact_v<_Writer>)
+                {
+                    compact_writer<bytes_writer> _compact{_writer};
+
+                    _append(_compact);
+                }
+                else
+                {
+                    _append(_writer);
+                }
+
+                _partial.shrink_to_fit();
+
+                detail::write_container_header(writer, _header, _size);
+
+                writer.write(_partial);
+            }
+        }
+        else if constexpr (std::is_trivially_copyable_v<remove_cvref_t<_Ty>>)
+        {
+            if constexpr (std::is_compound_v<_Ty>)
+            {
+                writer << data_header{d_pod, static_cast<std::uint32_t>(sizeof(_Ty))};
             }
 
             writer << object;
         }
-        else
+        else
+        {
+            static_assert(
+                Always_false<_Ty>,
+                "_Ty to serialize must be either of a standard STL container type, custom containers that implement standard iterator, "
+                "POD type or custom types that implement serialize() method");
+        }
+    }
+
+    /*
+     * Deserialize a object from binary format
+     */
+    template <
+        class _Ty,
+        class _Reader = bytes_reader,
+        std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
+    _Ty deserialize_object(_Reader &reader)
+    {
+        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be deserialized can not be pointer type");
+
+        if constexpr (has_deserialize_v<_Ty>)
+        {
+            return _Ty::deserialize(reader);
+        }
+        else if constexpr (is_specialize_of_v<_Ty, std::pair>)
+        {
+            using first_type = typename _Ty::first_type;
+            using second_type = typename _Ty::second_type;
+
+            auto _header = reader.template read<data_header>();
+
+            // runtime check
+            if (_header.length != 2 || _header.get_main_type() != d_pair)
+                return _Ty{};
+
+            return _Ty{reader.template read<first_type>(), reader.template read<second_type>()};
+        }
+        else if constexpr (is_specialize_of_v<_Ty, std::variant>)
+        {
+            using _Variant = _Ty;
+
+            auto _header = reader.template read<data_header>();
+
+            if (_header.length != std::variant_size_v<_Variant>)
+                return _Variant{};
+
+            auto _index = reader.template read<uint32_t>();
+
+            if (_index > _header.length)
+                return _Variant{};
+
+            return detail::deserialize_variant_impl<_Variant>(reader, _index, std::make_index_sequence<std::variant_size_v<_Variant>>{});
+        }
+        else if constexpr (is_specialize_of_v<_Ty, std::tuple>)
+        {
+            using _Tuple = _Ty;
+
+            auto _header = reader.template read<data_header>();
+
+            if (_header.length != std::tuple_size_v<_Tuple>)
+                return _Ty{};
+
+            return detail::deserialize_tuple_impl<_Tuple>(reader, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+        }
+        else if constexpr (is_view_v<_Ty>)
+        {
+            static_assert(has_buffer_v<_Reader>, "views can only be read from a reader that exposes its buffer");
+
+            return detail::read_view<_Ty>(reader);
+        }
+        else if constexpr (is_standard_container_v<_Ty>)
+        {
+            using value_type = typename _Ty::value_type;
+
+            auto _header = reader.template read<data_header>();
+            auto _type = _header.get_main_type();
+
+            if (_type == d_delta)
+                return detail::read_delta<std::remove_cv_t<_Ty>>(reader, _header);
+
+            if (_type == d_pair)
+                return detail::read_columns<std::remove_cv_t<_Ty>>(reader, _header);
+
+            auto _length = detail::read_container_length(reader, _header);
+
+            /* the offset table is not needed when all the elements are read */
+            if (_type == d_indexed)
+                _type = detail::skip_index(reader, _header, _length);
+
+            std::remove_cv_t<_Ty> container{};
+
+            // runtime check
+            if (!detail::fits_remaining<value_type>(_length, reader))
+                return container;
+
+            if constexpr (is_sequence_container_v<_Ty>)
+            {
+                // runtime check
+                if (_type == d_seq_container &&
+                    _header.template is_subtype_compitable<value_type>())
+                {
+                    /* elements are stored as raw bytes, so the whole block can be copied at once */
+                    if constexpr (is_contiguous_container_v<_Ty> && has_resize_v<_Ty> && is_trivially_serializable_v<value_type> &&
+                                  !detail::varint_encoded_v<_Reader, value_type>)
+                    {
+                        auto _bytes = _length * sizeof(value_type);
+
+                        // runtime check
+                        if (_bytes > reader.remaining())
+                            return container;
+
+                        container.resize(_length);
+
+                        reader.read(reinterpret_cast<uint8_t *>(container.data()), _bytes);
+                    }
+                    else
+                    {
+                        detail::reserve_elements(container, _length, reader);
+
+                        for (size_t i = 0; i < _length; i++)
+                        {
+                            container.push_back(reader.template read<value_type>());
+                        }
+                    }
+                }
+            }
+            else if constexpr (is_associated_container_v<_Ty>)
+            {
+                // runtime check
+                if (_type == d_aso_container &&
+                    _header.template is_subtype_compitable<value_type>())
+                {
+                    detail::reserve_elements(container, _length, reader);
+
+                    for (size_t i = 0; i < _length; i++)
+                    {
+                        container.insert(reader.template read<value_type>());
+                    }
+                }
+            }
+
+            return container;
+        }
+        else if constexpr (std::is_trivially_copyable_v<_Ty>)
+        {
+            if constexpr (std::is_compound_v<_Ty>)
+            {
+                auto _header = reader.template read<data_header>();
+
+                // runtime check
+                if (_header.length < sizeof(_Ty))
+                    return _Ty{};
+            }
+
+            return reader.template read<_Ty>();
+        }
+        else
+        {
+            static_assert(
+                Always_false<_Ty>,
+                "_Ty to deserialize must be either of a standard STL container type, custom containers that implement standard iterator, "
+                "POD type, arithmetic type or custom types that implement deserialize() method");
+        }
+    }
+
+    /*
+     * Serialize a container with an offset table in front of its elements, so that any element can be
+     * located without decoding the ones before it, see lazy_container
+     * `writer << zpacker::indexed(rows)`, the data can still be deserialized into the container as a whole
+     */
+    template <class _Container>
+    class indexed
+    {
+    public:
+        using container_type = _Container;
+        using value_type = typename _Container::value_type;
+
+        static_assert(is_sequence_container_v<_Container> || is_associated_container_v<_Container>,
+                      "only sequence and association containers can be indexed");
+
+        explicit indexed(const _Container &container) : m_container(std::addressof(container)) {}
+
+        size_t get_size() const
+        {
+            auto _length = elements_length();
+            auto _offset_size = offset_size(_length);
+
+            /* the count of a table of 64-bit offsets always follows the data_header */
+            auto _header_size = _offset_size == sizeof(std::uint64_t) ? sizeof(data_header) + sizeof(std::uint64_t) : sizeof(data_header);
+
+            return _header_size + sizeof(uint8_t) + (m_container->size() + 1) * _offset_size + _length;
+        }
+
+        template <class _Writer>
+        void serialize(_Writer &writer) const
+        {
+            static_assert(!is_compact_v<_Writer>, "the offset table of indexed can not be written in compact mode");
+
+            data_header _header{};
+
+            _header.set_main_type(d_indexed);
+            _header.set_sub_type(get_data_type<value_type>());
+
+            if (offset_size(elements_length()) == sizeof(std::uint32_t))
+            {
+                _header.length = static_cast<std::uint32_t>(m_container->size());
+
+                writer << _header << static_cast<uint8_t>(get_data_type<_Container>());
+
+                write_offsets<std::uint32_t>(writer);
+            }
+            else
+            {
+                _header.length = _large_length;
+
+                writer << _header << static_cast<std::uint64_t>(m_container->size()) << static_cast<uint8_t>(get_data_type<_Container>());
+
+                write_offsets<std::uint64_t>(writer);
+            }
+
+            for (auto &v : *m_container)
+                writer << v;
+        }
+
+    private:
+        /* the size of the elements area */
+        size_t elements_length() const
+        {
+            size_t length{};
+
+            for (auto &v : *m_container)
+                detail::get_element_size(v, length);
+
+            return length;
+        }
+
+        /* offsets are 64-bit when the element count or the size of the elements area does not fit in 32 bits */
+        size_t offset_size(size_t length) const
+        {
+            if (m_container->size() < _large_length && length <= (std::numeric_limits<std::uint32_t>::max)())
+                return sizeof(std::uint32_t);
+
+            return sizeof(std::uint64_t);
+        }
+
+        /* offsets[i] is where element i starts in the elements area, the last one is the size of the area */
+        template <class _Offset, class _Writer>
+        void write_offsets(_Writer &writer) const
+        {
+            _Offset _offset{0};
+
+            writer << _offset;
+
+            for (auto &v : *m_container)
+            {
+                size_t _size{};
+
+                detail::get_element_size(v, _size);
+
+                _offset += static_cast<_Offset>(_size);
+
+                writer << _offset;
+            }
+        }
+
+        const _Container *m_container;
+    };
+
+    /*
+     * Serialize a container of integers, or a map with integer keys, as the zigzag-encoded differences of
+     * consecutive keys written as varints, a map's values follow the keys in the same order
+     * `writer << zpacker::delta_encoded(ids)`, small steps such as those of a sorted id set take a byte or two
+     * The data is deserialized into the container as a whole, the values are rebuilt by a prefix sum of the deltas
+     */
+    template <class _Container>
+    class delta_encoded
+    {
+    public:
+        using container_type = _Container;
+        using value_type = typename _Container::value_type;
+        using key_type = detail::delta_key_t<value_type>;
+
+        static_assert(detail::is_delta_encodable_v<_Container>,
+                      "only sequence containers of integers and ordered association containers with integer keys can be delta encoded");
+
+        explicit delta_encoded(const _Container &container) : m_container(std::addressof(container)) {}
+
+        size_t get_size() const
+        {
+            size_t size = detail::container_header_size(m_container->size()) + sizeof(uint8_t) * 2 + sizeof(std::uint64_t) + delta_bytes();
+
+            if constexpr (!std::is_same_v<value_type, key_type>)
+            {
+                for (auto &v : *m_container)
+                    detail::get_element_size(v.second, size);
+            }
+
+            return size;
+        }
+
+        template <class _Writer>
+        void serialize(_Writer &writer) const
+        {
+            data_header _header{};
+
+            _header.set_main_type(d_delta);
+            _header.set_sub_type(get_data_type<value_type>());
+
+            detail::write_container_header(writer, _header, m_container->size());
+
+            writer << static_cast<uint8_t>(get_data_type<_Container>()) << static_cast<uint8_t>(get_data_type<key_type>())
+                   << static_cast<std::uint64_t>(delta_bytes());
+
+            uint8_t _buffer[1024];
+            size_t _size{};
+
+            key_type _previous{};
+
+            for (auto &v : *m_container)
+            {
+                if (_size > sizeof(_buffer) - detail::_varint_max_size)
+                {
+                    writer.write(_buffer, _size);
+
+                    _size = 0;
+                }
+
+                _size += detail::write_varint(_buffer + _size, detail::delta_of(_previous, detail::delta_key(v)));
+
+                _previous = detail::delta_key(v);
+            }
+
+            writer.write(_buffer, _size);
+
+            if constexpr (!std::is_same_v<value_type, key_type>)
+            {
+                for (auto &v : *m_container)
+                    writer << v.second;
+            }
+        }
+
+    private:
+        size_t delta_bytes() const
+        {
+            size_t bytes{};
+
+            key_type _previous{};
+
+            for (auto &v : *m_container)
+            {
+                bytes += detail::varint_size(detail::delta_of(_previous, detail::delta_key(v)));
+
+                _previous = detail::delta_key(v);
+            }
+
+            return bytes;
+        }
+
+        const _Container *m_container;
+    };
+
+    /*
+     * Serialize a container of pairs as two columns, all the keys as one block followed by all the values
+     * `writer << zpacker::columnar(prices)`, each column can then be copied, compressed or scanned on its own
+     * The data is deserialized into the container as a whole, which is rebuilt from the two columns
+     */
+    template <class _Container>
+    class columnar
+    {
+    public:
+        using container_type = _Container;
+        using value_type = typename _Container::value_type;
+
+        static_assert(detail::is_columnar_v<_Container>,
+                      "only sequence and association containers of pairs of trivially copyable members can be columnar");
+
+        explicit columnar(const _Container &container) : m_container(std::addressof(container)) {}
+
+        size_t get_size() const
+        {
+            return detail::container_header_size(m_container->size()) + sizeof(uint8_t) +
+                   m_container->size() * (sizeof(typename value_type::first_type) + sizeof(typename value_type::second_type));
+        }
+
+        template <class _Writer>
+        void serialize(_Writer &writer) const
+        {
+            data_header _header{};
+
+            _header.set_main_type(d_pair);
+
+            detail::write_container_header(writer, _header, m_container->size());
+
+            writer << static_cast<uint8_t>(get_data_type<_Container>());
+
+            for (auto &v : *m_container)
+                writer << v.first;
+
+            for (auto &v : *m_container)
+                writer << v.second;
+        }
+
+    private:
+        const _Container *m_container;
+    };
+
+    /*
+     * Random access to a serialized container, an element is decoded only when it is accessed
+     * Reads containers written by indexed, and containers of trivially copyable elements which have a fixed size,
+     * other containers come out empty. It points into the reader's buffer and is only valid as long as the buffer
+     */
+    template <class _Container>
+    class lazy_container
+    {
+    public:
+        using container_type = _Container;
+        using value_type = typename _Container::value_type;
+
+        static_assert(is_sequence_container_v<_Container> || is_associated_container_v<_Container>,
+                      "only sequence and association containers can be read lazily");
+
+        lazy_container() = default;
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        /*
+         * Decode the element at `index`, value_type{} is returned if it is out of range or malformed
+         */
+        value_type operator[](size_t index) const
+        {
+            auto _element = element(index);
+
+            bytes_reader_bounded _reader{_element.first, _element.second};
+
+            return _reader.template read<value_type>();
+        }
+
+        /*
+         * Decode only the key of the element at `index`
+         */
+        template <class _Ty = _Container>
+        typename _Ty::key_type key_at(size_t index) const
+        {
+            auto _element = element(index);
+
+            bytes_reader_bounded _reader{_element.first, _element.second};
+
+            if constexpr (is_specialize_of_v<value_type, std::pair> && !is_trivially_serializable_v<value_type>)
+            {
+                // runtime check
+                if (_reader.template read<data_header>().get_main_type() != d_pair)
+                    return {};
+            }
+
+            return _reader.template read<typename _Ty::key_type>();
+        }
+
+        /*
+         * Binary search on the keys of an ordered association container, only the keys visited are decoded
+         * Returns the index of the element or size() if there is no such key
+         */
+        template <class _Ty = _Container, class = typename _Ty::key_compare>
+        size_t find(const typename _Ty::key_type &key) const
+        {
+            typename _Ty::key_compare _less{};
+
+            size_t _first{0};
+            size_t _count{m_size};
+
+            while (_count > 0)
+            {
+                auto _step = _count / 2;
+
+                if (_less(key_at(_first + _step), key))
+                {
+                    _first += _step + 1;
+                    _count -= _step + 1;
+                }
+                else
+                {
+                    _count = _step;
+                }
+            }
+
+            if (_first < m_size && !_less(key, key_at(_first)))
+                return _first;
+
+            return m_size;
+        }
+
+        /*
+         * Decode all the elements
+         */
+        container_type decode() const
+        {
+            container_type container{};
+
+            bytes_reader_bounded _reader{m_elements, m_length};
+
+            detail::reserve_elements(container, m_size, _reader);
+
+            for (size_t i = 0; i < m_size; i++)
+            {
+                if constexpr (is_associated_container_v<_Container>)
+                    container.insert(_reader.template read<value_type>());
+                else
+                    container.push_back(_reader.template read<value_type>());
+            }
+
+            return container;
+        }
+
+        /*
+         * Decode the elements in [first, last) into `out`, they are read one after another from where `first` starts
+         * Return false if the range is out of bounds or the offset table is malformed
+         */
+        template <class _OutIt>
+        bool decode(size_t first, size_t last, _OutIt out) const
+        {
+            if (first > last || last > m_size)
+                return false;
+
+            auto _begin = position(first);
+            auto _end = position(last);
+
+            // runtime check
+            if (_begin > _end || _end > m_length)
+                return false;
+
+            bytes_reader_bounded _reader{m_elements + _begin, _end - _begin};
+
+            for (auto i = first; i < last; i++)
+                *out++ = _reader.template read<value_type>();
+
+            return true;
+        }
+
+        template <class _Reader>
+        static lazy_container deserialize(_Reader &reader)
+        {
+            static_assert(has_buffer_v<_Reader>, "lazy containers can only be read from a reader that exposes its buffer");
+            static_assert(!is_compact_v<_Reader>, "lazy containers can not be read in compact mode");
+
+            lazy_container self{};
+
+            auto _header = reader.template read<data_header>();
+            size_t _size = _header.length;
+
+            // runtime check
+            if (!_header.template is_subtype_compitable<value_type>())
+                return self;
+
+            if (_header.get_main_type() == d_indexed)
+            {
+                _size = detail::read_container_length(reader, _header);
+
+                auto _type = reader.template read<uint8_t>();
+
+                self.m_offset_size = detail::index_offset_size(_header);
+
+                // runtime check
+                if (_type != get_data_type<_Container>() || _size >= reader.remaining() / self.m_offset_size)
+                    return self;
+
+                auto _table = (_size + 1) * self.m_offset_size;
+
+                self.m_offsets = reader.data() + reader.count();
+
+                reader.skip(_table);
+
+                // runtime check, the first element starts the elements area
+                if (self.offset(0) != 0)
+                    return lazy_container{};
+
+                self.m_length = self.offset(_size);
+            }
+            else if (_header.get_main_type() == get_data_type<_Container>())
+            {
+                /* without an offset table only elements of a fixed size can be located */
+                if constexpr (is_trivially_serializable_v<value_type>)
+                {
+                    _size = detail::read_container_length(reader, _header);
+
+                    // runtime check
+                    if (_size > reader.remaining() / sizeof(value_type))
+                        return self;
+
+                    self.m_length = _size * sizeof(value_type);
+                }
+                else
+                {
+                    return self;
+                }
+            }
+            else
+            {
+                return self;
+            }
+
+            // runtime check
+            if (self.m_length > reader.remaining())
+                return lazy_container{};
+
+            self.m_elements = reader.data() + reader.count();
+            self.m_size = _size;
+
+            reader.skip(self.m_length);
+
+            return self;
+        }
+
+    private:
+        size_t offset(size_t index) const
+        {
+            if (m_offset_size == sizeof(std::uint64_t))
+            {
+                std::uint64_t _offset;
+
+                memcpy(&_offset, m_offsets + index * sizeof(std::uint64_t), sizeof(_offset));
+
+                return static_cast<size_t>(_offset);
+            }
+
+            std::uint32_t _offset;
+
+            memcpy(&_offset, m_offsets + index * sizeof(std::uint32_t), sizeof(_offset));
+
+            return _offset;
+        }
+
+        /* where the element at `index` starts in the elements area, `index` may be size() */
+        size_t position(size_t index) const
+        {
+            if (m_offsets == nullptr)
+                return index * sizeof(value_type);
+
+            return offset(index);
+        }
+
+        /* the bytes of the element at `index`, empty if it is out of range or the offset table is malformed */
+        std::pair<const uint8_t *, size_t> element(size_t index) const
         {
-            static_assert(
-                Always_false<_Ty>,
-                "_Ty to serialize must be either of a standard STL container type, custom containers that implement standard iterator, "
-                "POD type or custom types that implement serialize() method");
+            if (index >= m_size)
+                return {nullptr, 0};
+
+            if (m_offsets == nullptr)
+            {
+                if constexpr (is_trivially_serializable_v<value_type>)
+                    return {m_elements + index * sizeof(value_type), sizeof(value_type)};
+                else
+                    return {nullptr, 0};
+            }
+
+            auto _begin = offset(index);
+            auto _end = offset(index + 1);
+
+            // runtime check
+            if (_begin > _end || _end > m_length)
+                return {nullptr, 0};
+
+            return {m_elements + _begin, _end - _begin};
+        }
+
+        const uint8_t *m_offsets{nullptr};
+        const uint8_t *m_elements{nullptr};
+        size_t m_size{0};
+        size_t m_length{0};
+        size_t m_offset_size{sizeof(std::uint32_t)};
+    };
+
+    namespace detail
+    {
+        /* the checksum is updated during serialization instead of a separate pass over the payload */
+        template <class _CheckSum>
+        constexpr bool fuse_checksum_v = has_streaming_checksum_v<_CheckSum> && checksum_type_v<_CheckSum> != ct_none;
+
+        /*
+         * Size of the packer header in front of a payload of `length` bytes
+         */
+        constexpr size_t packer_header_size(size_t length)
+        {
+            return length > (std::numeric_limits<std::uint32_t>::max)() ? sizeof(packer_header_large) : sizeof(packer_header);
+        }
+
+        /*
+         * Move a payload of `length` bytes written behind a packer_header slot to make room for a packer_header_large,
+         * there must be room for the difference behind the payload
+         */
+        inline void widen_packer_header(uint8_t *data, size_t length)
+        {
+            memmove(data + sizeof(packer_header_large), data + sizeof(packer_header), length);
+        }
+
+        /*
+         * Widen the packer_header slot at `start` of `data` if the payload behind it needs a packer_header_large,
+         * return the length of the payload
+         */
+        inline size_t fit_packer_header(std::vector<uint8_t> &data, size_t start)
+        {
+            auto length = data.size() - start - sizeof(packer_header);
+
+            if (packer_header_size(length) != sizeof(packer_header))
+            {
+                data.resize(data.size() + sizeof(packer_header_large) - sizeof(packer_header));
+
+                widen_packer_header(data.data() + start, length);
+            }
+
+            return length;
+        }
+
+        /*
+         * Fill the packer header in front of a payload of `length` bytes whose checksum is `crc`
+         * A payload of 4 GiB or more gets a packer_header_large, see packer_header_size()
+         */
+        template <class _CheckSum>
+        void write_packer_header(uint8_t *data, size_t length, std::uint64_t crc, uint8_t flags = 0)
+        {
+            if (packer_header_size(length) != sizeof(packer_header))
+            {
+                packer_header_large ph{};
+
+                ph.version = VERSION;
+                ph.checksum = checksum_type_v<_CheckSum>;
+                ph.flags = flags | _flag_large;
+                ph.crc.crc64 = crc;
+                ph.length = length;
+
+                memcpy(data, &ph, sizeof(packer_header_large));
+
+                return;
+            }
+
+            packer_header ph{};
+
+            ph.set_version(VERSION);
+
+            ph.checksum = checksum_type_v<_CheckSum>;
+
+            ph.flags = flags;
+
+            ph.crc.crc64 = crc;
+
+            ph.length = static_cast<std::uint32_t>(length);
+
+            memcpy(data, &ph, sizeof(packer_header));
+        }
+
+        /*
+         * Fill the packer header in front of a payload of `length` bytes
+         */
+        template <class _CheckSum>
+        void patch_packer_header(uint8_t *data, size_t length, _CheckSum &checksum, uint8_t flags = 0)
+        {
+            write_packer_header<_CheckSum>(data, length, checksum(data + packer_header_size(length), length), flags);
+        }
+
+        /*
+         * Build a package of the encoded `payload`, the checksum covers the encoded bytes
+         */
+        template <class _CheckSum, class _Encoder>
+        std::vector<uint8_t> encode_package(const uint8_t *payload, size_t length, _CheckSum &checksum, _Encoder &encoder, uint8_t flags = 0)
+        {
+            auto encoded = encoder(payload, length);
+
+            std::vector<uint8_t> result(packer_header_size(encoded.size()) + encoded.size());
+
+            memcpy(result.data() + packer_header_size(encoded.size()), encoded.data(), encoded.size());
+
+            patch_packer_header(result.data(), encoded.size(), checksum, static_cast<uint8_t>(codec_type_v<_Encoder> | flags));
+
+            return result;
+        }
+
+        /*
+         * Read the packer header of any supported version, the payload behind it is not looked at
+         * Return the size of the header, or 0 if the header is truncated, malformed or not encoded by `codec`
+         * with the other `flags`
+         */
+        template <class _CheckSum>
+        size_t read_packer_header(const uint8_t *data, size_t length, packer_header_large &ph, codec_type codec = cd_none, uint8_t flags = 0)
+        {
+            std::uint16_t version{};
+            size_t header_size{};
+
+            if (length < sizeof(version))
+                return 0;
+
+            memcpy(&version, data, sizeof(version));
+
+            if (version == VERSION)
+            {
+                packer_header ph2{};
+
+                if (length < sizeof(packer_header))
+                    return 0;
+
+                memcpy(&ph2, data, sizeof(packer_header));
+
+                header_size = sizeof(packer_header);
+
+                // check checksum algorithm
+                if (ph2.checksum != checksum_type_v<_CheckSum>)
+                    return 0;
+
+                if (ph2.flags & _flag_large)
+                {
+                    if (length < sizeof(packer_header_large))
+                        return 0;
+
+                    memcpy(&ph, data, sizeof(packer_header_large));
+
+                    header_size = sizeof(packer_header_large);
+                }
+                else
+                {
+                    ph = packer_header_large{};
+                    ph.version = ph2.version;
+                    ph.checksum = ph2.checksum;
+                    ph.flags = ph2.flags;
+                    ph.crc.crc64 = ph2.crc.crc64;
+                    ph.length = ph2.length;
+                }
+            }
+            else if (version == VERSION_1)
+            {
+                packer_header_v1 ph1{};
+
+                if (length < sizeof(packer_header_v1))
+                    return 0;
+
+                memcpy(&ph1, data, sizeof(packer_header_v1));
+
+                header_size = sizeof(packer_header_v1);
+
+                ph = packer_header_large{};
+                ph.version = ph1.version;
+                ph.checksum = checksum_type_v<_CheckSum>;
+                ph.crc.crc64 = ph1.crc.crc32;
+                ph.length = ph1.length;
+            }
+            else
+            {
+                return 0;
+            }
+
+            // check codec, unknown flags are rejected
+            if ((ph.flags & ~_flag_large) != (codec | flags))
+                return 0;
+
+            return header_size;
+        }
+
+        /*
+         * Parse the packer header of any supported version, the payload is not verified
+         * Return the size of the header, or 0 if the package is malformed or not encoded by `codec`
+         */
+        template <class _CheckSum>
+        size_t parse_packer_header(const uint8_t *data, size_t length, packer_header_large &ph, codec_type codec = cd_none, uint8_t flags = 0)
+        {
+            auto header_size = read_packer_header<_CheckSum>(data, length, ph, codec, flags);
+            if (header_size == 0)
+                return 0;
+
+            if (ph.length > length - header_size)
+                return 0;
+
+            return header_size;
+        }
+
+        /*
+         * Parse the packer header of any supported version and verify the payload behind it
+         * Return the size of the header, or 0 if the package is malformed or fails the check
+         */
+        template <class _CheckSum>
+        size_t unpack_packer_header(const uint8_t *data, size_t length, _CheckSum &checksum, packer_header_large &ph, codec_type codec = cd_none, uint8_t flags = 0)
+        {
+            auto header_size = parse_packer_header<_CheckSum>(data, length, ph, codec, flags);
+            if (header_size == 0)
+                return 0;
+
+            // check checksum
+            if (static_cast<std::uint64_t>(checksum(data + header_size, static_cast<size_t>(ph.length))) != ph.crc.crc64)
+                return 0;
+
+            return header_size;
+        }
+
+        /*
+         * Deserialize the payload from `reader`, through a compact_reader if it was written in compact mode
+         */
+        template <class _Ty, bool _Compact, class _Reader>
+        _Ty read_payload(_Reader &reader)
+        {
+            if constexpr (_Compact)
+            {
+                compact_reader<_Reader> compact{reader};
+
+                return deserialize_object<_Ty>(compact);
+            }
+            else
+            {
+                return deserialize_object<_Ty>(reader);
+            }
+        }
+
+        /*
+         * Deserialize the payload behind the header while the checksum is updated on the fly
+         * The result is discarded if the payload fails the check
+         */
+        template <class _Ty, bool _Compact = false, class _CheckSum>
+        _Ty deserialize_checked(const uint8_t *data, const packer_header_large &ph, _CheckSum &checksum)
+        {
+            bytes_reader_bounded payload{data, static_cast<size_t>(ph.length)};
+
+            checksum_reader<bytes_reader_bounded, _CheckSum> reader{payload, checksum};
+
+            auto result = read_payload<_Ty, _Compact>(reader);
+
+            // trailing bytes are part of the checksum as well
+            reader.skip(reader.remaining());
+
+            if (static_cast<std::uint64_t>(reader.checksum()) != ph.crc.crc64)
+                return _Ty{};
+
+            return result;
+        }
+
+        /*
+         * Decode the verified payload and deserialize from the decoded bytes
+         */
+        template <class _Ty, bool _Compact = false, class _Decoder>
+        _Ty deserialize_decoded(const uint8_t *data, size_t length, _Decoder &decoder)
+        {
+            static_assert(!holds_view<_Ty>::value, "a view would refer to the temporary decoded buffer");
+
+            auto decoded = decoder(data, length);
+
+            bytes_reader reader{decoded};
+
+            return read_payload<_Ty, _Compact>(reader);
+        }
+
+        /*
+         * A range of records written like a sequence container, so a batch can be read back as a std::vector as well
+         */
+        template <class _Range>
+        struct batch
+        {
+            const _Range &records;
+
+            template <class _Writer>
+            void serialize(_Writer &writer) const
+            {
+                using value_type = remove_cvref_t<decltype(*std::begin(records))>;
+
+                data_header _header{};
+
+                _header.set_main_type(d_seq_container);
+                _header.set_sub_type(get_data_type<value_type>());
+
+                write_container_header(writer, _header, static_cast<size_t>(std::distance(std::begin(records), std::end(records))));
+
+                /* records stored as raw bytes are copied at once */
+                if constexpr (is_contiguous_container_v<_Range> && is_trivially_serializable_v<value_type> &&
+                              !varint_encoded_v<_Writer, value_type>)
+                {
+                    writer.write(reinterpret_cast<const uint8_t *>(records.data()), records.size() * sizeof(value_type));
+                }
+                else
+                {
+                    std::for_each(std::begin(records), std::end(records), [&writer](auto &v)
+                                  { writer << v; });
+                }
+            }
+        };
+
+        /*
+         * Read the records of a batch into `out`, return the number of records read or 0 if the batch is malformed
+         */
+        template <class _Ty, class _Reader, class _OutIt>
+        size_t read_batch(_Reader &reader, _OutIt &out)
+        {
+            auto _header = reader.template read<data_header>();
+            auto _type = _header.get_main_type();
+            auto _length = read_container_length(reader, _header);
+
+            if (_type == d_indexed)
+                _type = skip_index(reader, _header, _length);
+
+            // runtime check
+            if (_type != d_seq_container || !_header.template is_subtype_compitable<_Ty>())
+                return 0;
+
+            // runtime check, a bogus count is rejected before anything is written to `out`
+            if (!fits_remaining<_Ty>(_length, reader))
+                return 0;
+
+            for (size_t i = 0; i < _length; i++)
+                *out++ = reader.template read<_Ty>();
+
+            return _length;
         }
     }
 
-    /*
-     * Deserialize a object from binary format
-     */
     template <
         class _Ty,
-        class _Reader = bytes_reader,
-        std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
-    _Ty deserialize_object(_Reader &reader)
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    std::vector<uint8_t> serialize(const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
     {
-        static_assert(!std::is_pointer_v<remove_cvref_t<_Ty>>, "value_type in container _Ty to be deserialized can not be pointer type");
+        std::vector<uint8_t> data{};
 
-        if constexpr (has_deserialize_v<_Ty>)
+        data.reserve(_default_reserve_size);
+
+        // reserve the slot of packer header, it is patched once the payload is done
+        data.resize(sizeof(packer_header));
+
+        bytes_writer writer{data};
+
+        // serialization
+        if constexpr (codec_type_v<_Encoder> != cd_none)
         {
-            return _Ty::deserialize(reader);
+            serialize_object(writer, value);
+
+            return detail::encode_package(data.data() + sizeof(packer_header), data.size() - sizeof(packer_header), checksum, encoder);
         }
-        else if constexpr (is_specialize_of_v<_Ty, std::pair>)
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
         {
-            using first_type = typename _Ty::first_type;
-            using second_type = typename _Ty::second_type;
+            checksum_writer<bytes_writer, _CheckSum> checked{writer, checksum};
 
-            auto _header = reader.template read<data_header>();
+            serialize_object(checked, value);
 
-            // runtime check
-            if (_header.length != 2 || _header.get_main_type() != d_pair)
-                return _Ty{};
+            auto crc = checked.checksum();
 
-            return _Ty{reader.template read<first_type>(), reader.template read<second_type>()};
+            // a payload of 4 GiB or more needs the wider header
+            auto length = detail::fit_packer_header(data, 0);
+
+            detail::write_packer_header<_CheckSum>(data.data(), length, crc);
         }
-        else if constexpr (is_specialize_of_v<_Ty, std::variant>)
+        else
         {
-            using _Variant = _Ty;
+            serialize_object(writer, value);
 
-            auto _header = reader.template read<data_header>();
+            auto length = detail::fit_packer_header(data, 0);
 
-            if (_header.length != std::variant_size_v<_Variant>)
-                return _Variant{};
+            detail::patch_packer_header(data.data(), length, checksum);
+        }
 
-            auto _index = reader.template read<uint32_t>();
+        return data;
+    }
 
-            if (_index > _header.length)
-                return _Variant{};
+    /*
+     * Append a package to the end of `data`, packages appended one after another are walked by message_frames
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    void serialize_append(std::vector<uint8_t> &data, const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
+    {
+        auto start = data.size();
 
-            return detail::deserialize_variant_impl<_Variant>(reader, _index, std::make_index_sequence<std::variant_size_v<_Variant>>{});
+        // reserve the slot of packer header, it is patched once the payload is done
+        data.resize(start + sizeof(packer_header));
+
+        bytes_writer writer{data};
+
+        // serialization
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+        {
+            serialize_object(writer, value);
+
+            auto package = detail::encode_package(data.data() + start + sizeof(packer_header), data.size() - start - sizeof(packer_header), checksum, encoder);
+
+            data.resize(start);
+
+            data.insert(data.end(), package.begin(), package.end());
         }
-        else if constexpr (is_specialize_of_v<_Ty, std::tuple>)
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
         {
-            using _Tuple = _Ty;
+            checksum_writer<bytes_writer, _CheckSum> checked{writer, checksum};
 
-            auto _header = reader.template read<data_header>();
+            serialize_object(checked, value);
 
-            if (_header.length != std::tuple_size_v<_Tuple>)
-                return _Ty{};
+            auto crc = checked.checksum();
 
-            return detail::deserialize_tuple_impl<_Tuple>(reader, std::make_index_sequence<std::tuple_size_v<_Tuple>>{});
+            auto length = detail::fit_packer_header(data, start);
+
+            detail::write_packer_header<_CheckSum>(data.data() + start, length, crc);
         }
-        else if constexpr (is_standard_container_v<_Ty>)
+        else
         {
-            using value_type = typename _Ty::value_type;
+            serialize_object(writer, value);
 
-            auto _header = reader.template read<data_header>();
+            auto length = detail::fit_packer_header(data, start);
+
+            detail::patch_packer_header(data.data() + start, length, checksum);
+        }
+    }
+
+    /*
+     * Serialize with an output buffer presized by get_size()
+     * Every type in the object graph must report its exact size, the payload is written with no capacity check
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    std::vector<uint8_t> serialize(exact_size_t, const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
+    {
+        auto size = get_size(value);
+
+        auto header_size = detail::packer_header_size(size);
+
+        std::vector<uint8_t> data(header_size + size);
 
-            std::remove_cv_t<_Ty> container{};
+        bytes_writer_unchecked writer{data.data() + header_size, size};
 
-            if constexpr (is_sequence_container_v<_Ty>)
-            {
-                // runtime check
-                if (_header.get_main_type() == d_seq_container &&
-                    _header.template is_subtype_compitable<value_type>())
-                {
-                    for (std::uint32_t i = 0; i < _header.length; i++)
-                    {
-                        container.push_back(reader.template read<value_type>());
-                    }
-                }
-            }
-            else if constexpr (is_associated_container_v<_Ty>)
-            {
-                // runtime check
-                if (_header.get_main_type() == d_aso_container &&
-                    _header.template is_subtype_compitable<value_type>())
-                {
-                    for (std::uint32_t i = 0; i < _header.length; i++)
-                    {
-                        container.insert(reader.template read<value_type>());
-                    }
-                }
-            }
+        // serialization
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+        {
+            serialize_object(writer, value);
 
-            return container;
+            return detail::encode_package(data.data() + header_size, writer.count(), checksum, encoder);
         }
-        else if constexpr (std::is_trivially_copyable_v<_Ty>)
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
         {
-            if constexpr (std::is_compound_v<_Ty>)
-            {
-                auto _header = reader.template read<data_header>();
+            checksum_writer<bytes_writer_unchecked, _CheckSum> checked{writer, checksum};
 
-                // runtime check
-                if (_header.length < sizeof(_Ty))
-                    return _Ty{};
-            }
+            serialize_object(checked, value);
 
-            return reader.template read<_Ty>();
+            detail::write_packer_header<_CheckSum>(data.data(), writer.count(), checked.checksum());
         }
         else
         {
-            static_assert(
-                Always_false<_Ty>,
-                "_Ty to deserialize must be either of a standard STL container type, custom containers that implement standard iterator, "
-                "POD type, arithmetic type or custom types that implement deserialize() method");
+            serialize_object(writer, value);
+
+            detail::patch_packer_header(data.data(), writer.count(), checksum);
         }
+
+        return data;
     }
 
+    /*
+     * Serialize in the compact wire format, see compact_writer
+     * Lengths and small integers take fewer bytes at some cost in speed, the package is read by deserialize(compact, ...) only
+     */
     template <
         class _Ty,
-        class _CheckSum = empty_checksum>
-    std::vector<uint8_t> serialize(const _Ty &value, _CheckSum checksum = empty_checksum{})
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    std::vector<uint8_t> serialize(compact_t, const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
     {
         std::vector<uint8_t> data{};
-        std::vector<uint8_t> result{};
 
         data.reserve(_default_reserve_size);
 
+        // reserve the slot of packer header, it is patched once the payload is done
+        data.resize(sizeof(packer_header));
+
         bytes_writer writer{data};
 
         // serialization
-        serialize_object(writer, value);
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+        {
+            compact_writer<bytes_writer> compact{writer};
+
+            serialize_object(compact, value);
 
-        data.shrink_to_fit();
+            return detail::encode_package(data.data() + sizeof(packer_header), data.size() - sizeof(packer_header), checksum, encoder, _flag_compact);
+        }
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
+        {
+            checksum_writer<bytes_writer, _CheckSum> checked{writer, checksum};
 
-        result.reserve(data.size() + sizeof(packer_header));
+            compact_writer<checksum_writer<bytes_writer, _CheckSum>> compact{checked};
 
-        // insert packer header
-        packer_header ph{};
+            serialize_object(compact, value);
 
-        ph.set_version(VERSION);
+            auto crc = checked.checksum();
 
-        ph.crc.crc32 = checksum(data.data(), data.size());
+            // a payload of 4 GiB or more needs the wider header
+            auto length = detail::fit_packer_header(data, 0);
 
-        ph.length = static_cast<std::uint32_t>(data.size());
+            detail::write_packer_header<_CheckSum>(data.data(), length, crc, _flag_compact);
+        }
+        else
+        {
+            compact_writer<bytes_writer> compact{writer};
 
-        writer.reset(result);
+            serialize_object(compact, value);
 
-        writer << ph;
-        writer.write(data);
+            auto length = detail::fit_packer_header(data, 0);
 
-        result.shrink_to_fit();
+            detail::patch_packer_header(data.data(), length, checksum, _flag_compact);
+        }
 
-        return result;
+        return data;
     }
 
     template <
         class _Ty,
-        class _CheckSum = empty_checksum>
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
     std::vector<uint8_t> serialize(
         const void *buffer,
         size_t bufsize,
         const _Ty &value,
-        _CheckSum checksum = empty_checksum{})
+        _CheckSum checksum = empty_checksum{},
+        _Encoder encoder = empty_encoder{})
     {
-        std::vector<uint8_t> result{};
-
         bytes_writer_bounded writer{(uint8_t *)buffer, bufsize};
 
         // serialization
@@ -1374,77 +5624,426 @@ namespace zpacker
 
         auto length = writer.count();
 
-        result.reserve(writer.count() + sizeof(packer_header));
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+            return detail::encode_package((const uint8_t *)buffer, length, checksum, encoder);
 
-        // insert packer header
-        packer_header ph{};
+        std::vector<uint8_t> result(detail::packer_header_size(length) + length);
 
-        ph.set_version(VERSION);
+        memcpy(result.data() + detail::packer_header_size(length), buffer, length);
 
-        ph.crc.crc32 = checksum((uint8_t *)buffer, length);
+        detail::patch_packer_header(result.data(), length, checksum);
 
-        ph.length = static_cast<std::uint32_t>(length);
+        return result;
+    }
 
-        bytes_writer data_writer{result};
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder,
+        std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
+    _Ty deserialize(const std::vector<uint8_t> &data, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        packer_header_large ph{};
 
-        data_writer << ph;
-        data_writer.write((uint8_t *)buffer, length);
+        if constexpr (codec_type_v<_Decoder> != cd_none)
+        {
+            // the checksum covers the encoded bytes, it is verified before decoding
+            auto header_size = detail::unpack_packer_header(data.data(), data.size(), checksum, ph, codec_type_v<_Decoder>);
+            if (header_size == 0)
+                return _Ty{};
 
-        result.shrink_to_fit();
+            return detail::deserialize_decoded<_Ty>(data.data() + header_size, ph.length, decoder);
+        }
 
-        return result;
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
+        {
+            auto header_size = detail::parse_packer_header<_CheckSum>(data.data(), data.size(), ph);
+            if (header_size == 0)
+                return _Ty{};
+
+            return detail::deserialize_checked<_Ty>(data.data() + header_size, ph, checksum);
+        }
+
+        bytes_reader reader{data};
+
+        // check header and checksum
+        auto header_size = detail::unpack_packer_header(data.data(), data.size(), checksum, ph);
+        if (header_size == 0)
+            return _Ty{};
+
+        reader.skip(header_size);
+
+        // perform deserialize
+        return deserialize_object<_Ty>(reader);
     }
 
     template <
         class _Ty,
         class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder,
         std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
-    _Ty deserialize(const std::vector<uint8_t> &data, _CheckSum checksum = empty_checksum{})
+    _Ty deserialize(
+        const void *buffer,
+        size_t length,
+        _CheckSum checksum = empty_checksum{},
+        _Decoder decoder = empty_decoder{})
     {
-        bytes_reader reader{data};
+        packer_header_large ph{};
 
-        packer_header ph{};
+        if constexpr (codec_type_v<_Decoder> != cd_none)
+        {
+            // the checksum covers the encoded bytes, it is verified before decoding
+            auto header_size = detail::unpack_packer_header((const uint8_t *)buffer, length, checksum, ph, codec_type_v<_Decoder>);
+            if (header_size == 0)
+                return _Ty{};
 
-        reader >> ph;
+            return detail::deserialize_decoded<_Ty>((const uint8_t *)buffer + header_size, ph.length, decoder);
+        }
 
-        // check header
-        if (ph.version != VERSION)
-            return _Ty{};
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
+        {
+            auto header_size = detail::parse_packer_header<_CheckSum>((const uint8_t *)buffer, length, ph);
+            if (header_size == 0)
+                return _Ty{};
+
+            return detail::deserialize_checked<_Ty>((const uint8_t *)buffer + header_size, ph, checksum);
+        }
 
-        // check checksum
-        std::uint32_t crc = checksum(data.data() + sizeof(packer_header), ph.length);
-        if (crc != ph.crc.crc32)
+        bytes_reader_bounded reader{(uint8_t *)buffer, length};
+
+        // check header and checksum
+        auto header_size = detail::unpack_packer_header((const uint8_t *)buffer, length, checksum, ph);
+        if (header_size == 0)
             return _Ty{};
 
+        reader.skip(header_size);
+
         // perform deserialize
         return deserialize_object<_Ty>(reader);
     }
 
+    /*
+     * Deserialize a package written by serialize(compact, ...)
+     */
     template <
         class _Ty,
         class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder,
         std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
     _Ty deserialize(
+        compact_t,
         const void *buffer,
         size_t length,
-        _CheckSum checksum = empty_checksum{})
+        _CheckSum checksum = empty_checksum{},
+        _Decoder decoder = empty_decoder{})
     {
-        bytes_reader_bounded reader{(uint8_t *)buffer, length};
+        packer_header_large ph{};
+
+        auto data = static_cast<const uint8_t *>(buffer);
+
+        if constexpr (codec_type_v<_Decoder> != cd_none)
+        {
+            // the checksum covers the encoded bytes, it is verified before decoding
+            auto header_size = detail::unpack_packer_header(data, length, checksum, ph, codec_type_v<_Decoder>, _flag_compact);
+            if (header_size == 0)
+                return _Ty{};
+
+            return detail::deserialize_decoded<_Ty, true>(data + header_size, ph.length, decoder);
+        }
 
-        packer_header ph{};
+        else if constexpr (detail::fuse_checksum_v<_CheckSum>)
+        {
+            auto header_size = detail::parse_packer_header<_CheckSum>(data, length, ph, cd_none, _flag_compact);
+            if (header_size == 0)
+                return _Ty{};
 
-        reader >> ph;
+            return detail::deserialize_checked<_Ty, true>(data + header_size, ph, checksum);
+        }
 
-        // check header
-        if (ph.version != VERSION)
+        // check header and checksum
+        auto header_size = detail::unpack_packer_header(data, length, checksum, ph, cd_none, _flag_compact);
+        if (header_size == 0)
             return _Ty{};
 
-        // check checksum
-        std::uint32_t crc = checksum((uint8_t *)buffer + sizeof(packer_header), ph.length);
-        if (crc != ph.crc.crc32)
-            return _Ty{};
+        bytes_reader_bounded reader{data + header_size, static_cast<size_t>(ph.length)};
 
         // perform deserialize
-        return deserialize_object<_Ty>(reader);
+        return detail::read_payload<_Ty, true>(reader);
+    }
+
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder,
+        std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
+    _Ty deserialize(compact_t, const std::vector<uint8_t> &data, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        return deserialize<_Ty>(compact, data.data(), data.size(), checksum, decoder);
+    }
+
+    /*
+     * Serialize a range of records into one package, under one packer header and one checksum
+     * The payload is laid out like a sequence container, so deserialize<std::vector<T>>() reads it back as well
+     */
+    template <
+        class _Range,
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    std::vector<uint8_t> serialize_many(const _Range &records, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
+    {
+        return serialize(detail::batch<_Range>{records}, checksum, encoder);
+    }
+
+    /*
+     * Read the records of a serialize_many() package into `out`, the package is verified before the first record is written
+     * Return the number of records read, or 0 if the package is malformed or fails the check
+     */
+    template <
+        class _Ty,
+        class _OutIt,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    size_t deserialize_many(const void *buffer, size_t length, _OutIt out, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        packer_header_large ph{};
+
+        auto data = static_cast<const uint8_t *>(buffer);
+
+        // check header and checksum
+        auto header_size = detail::unpack_packer_header(data, length, checksum, ph, codec_type_v<_Decoder>);
+        if (header_size == 0)
+            return 0;
+
+        if constexpr (codec_type_v<_Decoder> != cd_none)
+        {
+            static_assert(!holds_view<_Ty>::value, "a view would refer to the temporary decoded buffer");
+
+            auto decoded = decoder(data + header_size, ph.length);
+
+            bytes_reader reader{decoded};
+
+            return detail::read_batch<_Ty>(reader, out);
+        }
+        else
+        {
+            bytes_reader_bounded reader{data + header_size, static_cast<size_t>(ph.length)};
+
+            return detail::read_batch<_Ty>(reader, out);
+        }
+    }
+
+    template <
+        class _Ty,
+        class _OutIt,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    size_t deserialize_many(const std::vector<uint8_t> &data, _OutIt out, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        return deserialize_many<_Ty>(data.data(), data.size(), out, checksum, decoder);
     }
-}
\ No newline at end of file
+
+    /*
+     * One package out of a buffer of packages written back to back
+     */
+    class message_frame
+    {
+    public:
+        message_frame(const uint8_t *data, size_t header_size, const packer_header_large &header)
+            : m_data(data), m_header_size(header_size), m_header(header) {}
+
+        /*
+         * Get the beginning of the package, packer header included
+         */
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        /*
+         * Get the size of the package, packer header included
+         */
+        size_t size() const
+        {
+            return m_header_size + m_header.length;
+        }
+
+        const packer_header_large &header() const
+        {
+            return m_header;
+        }
+
+        /*
+         * Reader over the payload as stored, nothing is copied and the checksum is not verified
+         */
+        bytes_reader_bounded reader() const
+        {
+            return bytes_reader_bounded{m_data + m_header_size, static_cast<size_t>(m_header.length)};
+        }
+
+        /*
+         * Verify and deserialize the package, views refer to the buffer of the frames
+         */
+        template <
+            class _Ty,
+            class _CheckSum = empty_checksum,
+            class _Decoder = empty_decoder>
+        _Ty get(_CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{}) const
+        {
+            return deserialize<_Ty>(m_data, size(), checksum, decoder);
+        }
+
+    private:
+        const uint8_t *m_data;
+        size_t m_header_size;
+        packer_header_large m_header;
+    };
+
+    /*
+     * Walk the packages written back to back in a buffer, e.g. the bytes received from a pipe or a shared memory ring
+     * Only the packer headers are parsed, the frames are views into the buffer which must outlive them
+     * A truncated package at the end is left out, drop the consumed() bytes and walk again once more bytes arrive
+     */
+    template <
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    class message_frames
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = message_frame;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const message_frame *;
+            using reference = message_frame;
+
+            iterator() = default;
+
+            iterator(const uint8_t *data, const uint8_t *end) : m_data(data), m_end(end) {}
+
+            message_frame operator*() const
+            {
+                packer_header_large ph{};
+
+                auto header_size = detail::read_packer_header<_CheckSum>(m_data, static_cast<size_t>(m_end - m_data), ph, codec_type_v<_Decoder>);
+
+                return message_frame{m_data, header_size, ph};
+            }
+
+            iterator &operator++()
+            {
+                m_data += (**this).size();
+
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto result = *this;
+
+                ++*this;
+
+                return result;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return m_data == other.m_data;
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return m_data != other.m_data;
+            }
+
+        private:
+            const uint8_t *m_data{nullptr};
+            const uint8_t *m_end{nullptr};
+        };
+
+        message_frames(const uint8_t *data, size_t length) : m_data(data), m_length(length)
+        {
+            // only the headers are parsed, the frames are verified when they are deserialized
+            while (m_consumed < m_length)
+            {
+                packer_header_large ph{};
+
+                auto left = m_length - m_consumed;
+
+                auto header_size = detail::read_packer_header<_CheckSum>(m_data + m_consumed, left, ph, codec_type_v<_Decoder>);
+
+                // a header shorter than the current version may still be completed by the bytes to come
+                if (header_size == 0)
+                {
+                    m_malformed = left >= sizeof(packer_header_large);
+
+                    break;
+                }
+
+                if (ph.length > left - header_size)
+                    break;
+
+                m_consumed += header_size + ph.length;
+
+                ++m_count;
+            }
+        }
+
+        explicit message_frames(const std::vector<uint8_t> &data) : message_frames(data.data(), data.size()) {}
+
+        iterator begin() const
+        {
+            return iterator{m_data, m_data + m_consumed};
+        }
+
+        iterator end() const
+        {
+            return iterator{m_data + m_consumed, m_data + m_consumed};
+        }
+
+        /*
+         * Get the number of complete packages
+         */
+        size_t size() const
+        {
+            return m_count;
+        }
+
+        bool empty() const
+        {
+            return m_count == 0;
+        }
+
+        /*
+         * Get the bytes taken by the complete packages, the caller may drop them from the buffer
+         */
+        size_t consumed() const
+        {
+            return m_consumed;
+        }
+
+        /*
+         * The buffer ends with a truncated package, more bytes are needed to complete it
+         */
+        bool partial() const
+        {
+            return !m_malformed && m_consumed < m_length;
+        }
+
+        /*
+         * The bytes behind the complete packages can never form a package, the stream is out of sync
+         */
+        bool malformed() const
+        {
+            return m_malformed;
+        }
+
+    private:
+        const uint8_t *m_data;
+        size_t m_length;
+        size_t m_consumed{0};
+        size_t m_count{0};
+        bool m_malformed{false};
+    };
+}
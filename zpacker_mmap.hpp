@@ -0,0 +1,628 @@
+#pragma once
+
+/*
+ * Memory-mapped file reader and writer
+ * Include zpacker.hpp or zpacker_20.hpp before this header to choose the language level, zpacker.hpp is used otherwise
+ */
+#if !defined(ZPACKER_HPP) && !defined(ZPACKER_20_HPP)
+#include "zpacker.hpp"
+#endif
+
+#include <limits>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zpacker
+{
+    /*
+     * How the pages of a mapped file are going to be accessed, passed to madvise()
+     */
+    enum class map_access
+    {
+        normal,
+        /* the whole file is deserialized front to back, pages are read ahead aggressively */
+        sequential,
+        /* a few elements are picked out, e.g. by lazy_container, read-ahead is disabled */
+        random,
+        /* the whole file is needed soon, paging in starts right away */
+        willneed
+    };
+
+    namespace detail
+    {
+        constexpr size_t _min_map_size = 64 * 1024;
+
+#if defined(_WIN32)
+        inline void unmap_file(void *data, size_t)
+        {
+            UnmapViewOfFile(data);
+        }
+#else
+        inline void unmap_file(void *data, size_t length)
+        {
+            munmap(data, length);
+        }
+
+        inline int map_advice(map_access access)
+        {
+            switch (access)
+            {
+            case map_access::sequential:
+                return MADV_SEQUENTIAL;
+            case map_access::random:
+                return MADV_RANDOM;
+            case map_access::willneed:
+                return MADV_WILLNEED;
+            default:
+                return MADV_NORMAL;
+            }
+        }
+#endif
+    }
+
+    /*
+     * Reader over a read-only mapping of a whole file, pages are loaded by the page cache when they are touched
+     * It reads exactly like bytes_reader_bounded, views and lazy containers read from it point into the mapping
+     * A file that can not be opened or mapped reads as empty, see is_open()
+     */
+    class mapped_file_reader : public bytes_reader_bounded
+    {
+    public:
+        explicit mapped_file_reader(const char *path, map_access access = map_access::sequential) : bytes_reader_bounded(nullptr, 0)
+        {
+            open(path, access);
+        }
+
+        mapped_file_reader(mapped_file_reader &&other) noexcept : bytes_reader_bounded(other)
+        {
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_open = std::exchange(other.m_open, false);
+
+            other.reset(nullptr, 0);
+        }
+
+        mapped_file_reader &operator=(mapped_file_reader &&other) noexcept
+        {
+            if (this != std::addressof(other))
+            {
+                close();
+
+                bytes_reader_bounded::operator=(other);
+
+                m_mapping = std::exchange(other.m_mapping, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_open = std::exchange(other.m_open, false);
+
+                other.reset(nullptr, 0);
+            }
+
+            return *this;
+        }
+
+        mapped_file_reader(const mapped_file_reader &) = delete;
+        mapped_file_reader &operator=(const mapped_file_reader &) = delete;
+
+        ~mapped_file_reader()
+        {
+            close();
+        }
+
+        template <class _Vty>
+        mapped_file_reader &operator>>(_Vty &val)
+        {
+            val = this->template read<_Vty>();
+
+            return *this;
+        }
+
+        /*
+         * An empty file is open but has nothing mapped
+         */
+        bool is_open() const
+        {
+            return m_open;
+        }
+
+        /*
+         * Get the size of the file
+         */
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        void close()
+        {
+            if (m_mapping != nullptr)
+                detail::unmap_file(m_mapping, m_size);
+
+            m_mapping = nullptr;
+            m_size = 0;
+            m_open = false;
+
+            reset(nullptr, 0);
+        }
+
+    private:
+#if defined(_WIN32)
+        void open(const char *path, map_access access)
+        {
+            DWORD flags = FILE_ATTRIBUTE_NORMAL;
+
+            if (access == map_access::sequential)
+                flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+            else if (access == map_access::random)
+                flags |= FILE_FLAG_RANDOM_ACCESS;
+
+            auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return;
+
+            LARGE_INTEGER size{};
+
+            if (GetFileSizeEx(file, &size) && size.QuadPart == 0)
+                m_open = true;
+            else if (size.QuadPart > 0 && static_cast<unsigned long long>(size.QuadPart) <= (std::numeric_limits<size_t>::max)())
+            {
+                // the mapping object is kept alive by the view
+                auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+                if (mapping != nullptr)
+                {
+                    m_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+                    CloseHandle(mapping);
+                }
+
+                if (m_mapping != nullptr)
+                {
+                    m_size = static_cast<size_t>(size.QuadPart);
+                    m_open = true;
+                }
+            }
+
+            CloseHandle(file);
+
+            reset(static_cast<const uint8_t *>(m_mapping), m_size);
+        }
+#else
+        void open(const char *path, map_access access)
+        {
+            auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return;
+
+            struct stat st{};
+
+            if (fstat(fd, &st) == 0 && st.st_size == 0)
+                m_open = true;
+            else if (st.st_size > 0 && static_cast<unsigned long long>(st.st_size) <= (std::numeric_limits<size_t>::max)())
+            {
+                auto mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+                if (mapping != MAP_FAILED)
+                {
+                    m_mapping = mapping;
+                    m_size = static_cast<size_t>(st.st_size);
+                    m_open = true;
+
+                    // only a hint, the mapping works without it
+                    madvise(m_mapping, m_size, detail::map_advice(access));
+                }
+            }
+
+            // the mapping keeps the file referenced
+            ::close(fd);
+
+            reset(static_cast<const uint8_t *>(m_mapping), m_size);
+        }
+#endif
+
+        void *m_mapping{nullptr};
+        size_t m_size{0};
+        bool m_open{false};
+    };
+
+    /*
+     * Writer into a shared mapping of a file, the file grows geometrically while writing and is cut
+     * to the bytes written by close(). Writes are dropped once the file can not be grown, close() reports it
+     */
+    class mapped_file_writer
+    {
+    public:
+        explicit mapped_file_writer(const char *path, size_t reserve = detail::_min_map_size)
+        {
+            open(path);
+
+            if (m_open)
+                grow(reserve);
+        }
+
+        mapped_file_writer(mapped_file_writer &&other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr)),
+              m_pos(std::exchange(other.m_pos, 0)),
+              m_capacity(std::exchange(other.m_capacity, 0)),
+              m_open(std::exchange(other.m_open, false)),
+              m_failed(std::exchange(other.m_failed, false)),
+              m_file(std::exchange(other.m_file, _invalid_file))
+        {
+        }
+
+        mapped_file_writer &operator=(mapped_file_writer &&other) noexcept
+        {
+            if (this != std::addressof(other))
+            {
+                close();
+
+                m_data = std::exchange(other.m_data, nullptr);
+                m_pos = std::exchange(other.m_pos, 0);
+                m_capacity = std::exchange(other.m_capacity, 0);
+                m_open = std::exchange(other.m_open, false);
+                m_failed = std::exchange(other.m_failed, false);
+                m_file = std::exchange(other.m_file, _invalid_file);
+            }
+
+            return *this;
+        }
+
+        mapped_file_writer(const mapped_file_writer &) = delete;
+        mapped_file_writer &operator=(const mapped_file_writer &) = delete;
+
+        ~mapped_file_writer()
+        {
+            close();
+        }
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                write(reinterpret_cast<const uint8_t *>(std::addressof(val)), sizeof(_Vty));
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            write(data.data(), data.size());
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            // the mapping may be gone after a failed grow, nothing is written from then on
+            if (m_failed || m_data == nullptr)
+                return;
+
+            if (length > m_capacity - m_pos && !grow(m_pos + length))
+                return;
+
+            if (length > 0)
+            {
+                memcpy(m_data + m_pos, data, length);
+
+                m_pos += length;
+            }
+        }
+
+        template <class _Vty>
+        mapped_file_writer &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        template <class _Ty>
+        bool can_write() const
+        {
+            return m_open && !m_failed;
+        }
+
+        /*
+         * Get the total bytes written
+         */
+        size_t count() const
+        {
+            return m_pos;
+        }
+
+        /*
+         * Bytes that can be written before the file has to grow
+         */
+        size_t remaining() const
+        {
+            return m_failed || m_data == nullptr ? 0 : m_capacity - m_pos;
+        }
+
+        /*
+         * Get the beginning of the mapping, it moves when the file grows
+         */
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        uint8_t *data()
+        {
+            return m_data;
+        }
+
+        bool is_open() const
+        {
+            return m_open;
+        }
+
+        /*
+         * Write the bytes written so far back to the file
+         */
+        bool flush()
+        {
+            if (m_data == nullptr || m_pos == 0)
+                return m_open;
+
+#if defined(_WIN32)
+            return FlushViewOfFile(m_data, m_pos) && FlushFileBuffers(m_file);
+#else
+            return msync(m_data, m_pos, MS_SYNC) == 0;
+#endif
+        }
+
+        /*
+         * Unmap and cut the file to the bytes written
+         * Return false if a write was dropped or the file could not be cut
+         */
+        bool close()
+        {
+            if (!m_open)
+                return false;
+
+            if (m_data != nullptr)
+                detail::unmap_file(m_data, m_capacity);
+
+#if defined(_WIN32)
+            LARGE_INTEGER size{};
+
+            size.QuadPart = static_cast<LONGLONG>(m_pos);
+
+            auto truncated = SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN) && SetEndOfFile(m_file);
+
+            CloseHandle(m_file);
+#else
+            auto truncated = ftruncate(m_file, static_cast<off_t>(m_pos)) == 0;
+
+            ::close(m_file);
+#endif
+
+            auto result = truncated && !m_failed;
+
+            m_data = nullptr;
+            m_pos = 0;
+            m_capacity = 0;
+            m_open = false;
+            m_failed = false;
+            m_file = _invalid_file;
+
+            return result;
+        }
+
+    private:
+#if defined(_WIN32)
+        using file_handle = HANDLE;
+
+        static inline const file_handle _invalid_file = INVALID_HANDLE_VALUE;
+
+        void open(const char *path)
+        {
+            m_file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+            m_open = m_file != INVALID_HANDLE_VALUE;
+        }
+
+        uint8_t *remap(size_t capacity)
+        {
+            if (m_data != nullptr)
+                UnmapViewOfFile(m_data);
+
+            m_data = nullptr;
+
+            // the file is extended to the size of the mapping object
+            auto mapping = CreateFileMappingA(
+                m_file,
+                nullptr,
+                PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<unsigned long long>(capacity) >> 32),
+                static_cast<DWORD>(capacity),
+                nullptr);
+
+            if (mapping == nullptr)
+                return nullptr;
+
+            auto data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, capacity);
+
+            CloseHandle(mapping);
+
+            return static_cast<uint8_t *>(data);
+        }
+#else
+        using file_handle = int;
+
+        static constexpr file_handle _invalid_file = -1;
+
+        void open(const char *path)
+        {
+            m_file = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+            m_open = m_file >= 0;
+        }
+
+        uint8_t *remap(size_t capacity)
+        {
+            if (ftruncate(m_file, static_cast<off_t>(capacity)) != 0)
+                return nullptr;
+
+            void *data = MAP_FAILED;
+
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+            if (m_data != nullptr)
+                data = mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+            else
+#endif
+            {
+                if (m_data != nullptr)
+                    munmap(m_data, m_capacity);
+
+                m_data = nullptr;
+
+                data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+            }
+
+            return data == MAP_FAILED ? nullptr : static_cast<uint8_t *>(data);
+        }
+#endif
+
+        /*
+         * Make room for `required` bytes, the capacity at least doubles so that growing costs amortized O(1)
+         */
+        bool grow(size_t required)
+        {
+            if (!m_open || m_failed)
+                return false;
+
+            if (required <= m_capacity)
+                return true;
+
+            auto capacity = (std::max)({required, m_capacity * 2, detail::_min_map_size});
+
+            auto data = remap(capacity);
+
+            // the old mapping is gone if it was moved, so no more bytes can be written
+            if (data == nullptr)
+            {
+                if (m_data == nullptr)
+                    m_capacity = 0;
+
+                m_failed = true;
+
+                return false;
+            }
+
+            m_data = data;
+            m_capacity = capacity;
+
+            return true;
+        }
+
+        uint8_t *m_data{nullptr};
+        size_t m_pos{0};
+        size_t m_capacity{0};
+        bool m_open{false};
+        bool m_failed{false};
+        file_handle m_file{_invalid_file};
+    };
+
+    namespace detail
+    {
+        /*
+         * Widen the packer_header slot at the beginning of the file if the payload behind it needs a packer_header_large,
+         * return the length of the payload
+         */
+        inline size_t fit_packer_header(mapped_file_writer &writer)
+        {
+            auto length = writer.count() - sizeof(packer_header);
+
+            if (packer_header_size(length) != sizeof(packer_header))
+            {
+                uint8_t padding[sizeof(packer_header_large) - sizeof(packer_header)]{};
+
+                writer.write(padding, sizeof(padding));
+
+                if (writer.can_write<uint8_t>())
+                    widen_packer_header(writer.data(), length);
+            }
+
+            return length;
+        }
+    }
+
+    /*
+     * Serialize a package straight into the mapped file at `path`, the file is replaced
+     * Return false if the file could not be written completely
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    bool serialize_file(const char *path, const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{})
+    {
+        mapped_file_writer writer{path};
+
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+        {
+            writer.write(serialize(value, checksum, encoder));
+
+            return writer.close();
+        }
+
+        // reserve the slot of packer header, it is patched once the payload is done
+        writer << packer_header{};
+
+        if constexpr (detail::fuse_checksum_v<_CheckSum>)
+        {
+            checksum_writer<mapped_file_writer, _CheckSum> checked{writer, checksum};
+
+            serialize_object(checked, value);
+
+            auto crc = checked.checksum();
+
+            // a payload of 4 GiB or more needs the wider header
+            auto length = detail::fit_packer_header(writer);
+
+            if (writer.can_write<uint8_t>())
+                detail::write_packer_header<_CheckSum>(writer.data(), length, crc);
+        }
+        else
+        {
+            serialize_object(writer, value);
+
+            auto length = detail::fit_packer_header(writer);
+
+            if (writer.can_write<uint8_t>())
+                detail::patch_packer_header(writer.data(), length, checksum);
+        }
+
+        return writer.close();
+    }
+
+    /*
+     * Deserialize a package from the mapped file at `path`
+     * Views can not be read this way since the file is unmapped on return, use mapped_file_reader for them
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    _Ty deserialize_file(const char *path, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        static_assert(!holds_view<_Ty>::value, "a view would refer to the file after it is unmapped");
+
+        mapped_file_reader reader{path};
+
+        return deserialize<_Ty>(reader.data(), reader.size(), checksum, decoder);
+    }
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+/*
+ * Parallel serialization and deserialization of large random access containers, it needs std::thread so it is kept out of the core headers
+ * Include zpacker.hpp or zpacker_20.hpp before this header to choose the language level, zpacker.hpp is used otherwise
+ */
+#if !defined(ZPACKER_HPP) && !defined(ZPACKER_20_HPP)
+#include "zpacker.hpp"
+#endif
+
+#include <atomic>
+#include <iterator>
+#include <thread>
+
+namespace zpacker
+{
+    /* fewest elements encoded by one task, smaller containers are serialized on the calling thread */
+    constexpr size_t _parallel_min_chunk = 16 * 1024;
+
+    /* tasks per thread, so a thread that is done early picks up the work of a slow one */
+    constexpr size_t _parallel_chunks_per_thread = 4;
+
+    /* fewest bytes checksummed by one task */
+    constexpr size_t _parallel_min_checksum_block = 256 * 1024;
+
+    namespace detail
+    {
+        /*
+         * Where `chunk` starts when `length` elements are split into `chunks` chunks of nearly the same size
+         */
+        inline size_t chunk_begin(size_t length, size_t chunks, size_t chunk)
+        {
+            return length / chunks * chunk + (std::min)(chunk, length % chunks);
+        }
+
+        /*
+         * Run `task(i)` for every i in [0, count) on up to `threads` threads, the calling thread is one of them
+         */
+        template <class _Task>
+        void parallel_for(size_t count, size_t threads, const _Task &task)
+        {
+            std::atomic<size_t> next{0};
+
+            auto worker = [&next, count, &task]()
+            {
+                for (auto i = next++; i < count; i = next++)
+                    task(i);
+            };
+
+            std::vector<std::thread> pool{};
+
+            threads = (std::min)(threads, count);
+
+            pool.reserve(threads - 1);
+
+            for (size_t i = 1; i < threads; ++i)
+                pool.emplace_back(worker);
+
+            worker();
+
+            for (auto &thread : pool)
+                thread.join();
+        }
+    }
+
+    /*
+     * Checksum of `length` bytes on `threads` threads (0 for one per core), equal to checksum(data, length)
+     * Every thread checks its own blocks, the results are merged in order by the combine() of the checksum policy
+     */
+    template <class _CheckSum>
+    auto parallel_checksum(const _CheckSum &checksum, const uint8_t *data, size_t length, size_t threads = 0)
+    {
+        static_assert(has_checksum_combine_v<_CheckSum>, "the checksum must implement combine() to be computed in parallel");
+
+        if (threads == 0)
+            threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+        auto chunks = (std::min)(threads * _parallel_chunks_per_thread, length / _parallel_min_checksum_block);
+
+        if (threads < 2 || chunks < 2)
+            return checksum(data, length);
+
+        std::vector<decltype(checksum(data, length))> checksums(chunks);
+
+        detail::parallel_for(chunks, threads, [&](size_t chunk)
+                             {
+            auto first = detail::chunk_begin(length, chunks, chunk);
+
+            checksums[chunk] = checksum(data + first, detail::chunk_begin(length, chunks, chunk + 1) - first); });
+
+        auto result = checksums[0];
+
+        for (size_t i = 1; i < chunks; ++i)
+            result = checksum.combine(result, checksums[i], detail::chunk_begin(length, chunks, i + 1) - detail::chunk_begin(length, chunks, i));
+
+        return result;
+    }
+
+    /*
+     * Serialize a random access sequence container on `threads` threads (0 for one per core), the output is byte-identical to serialize()
+     * The elements are split into chunks whose sizes are taken from get_size() and prefix-summed into offsets of one buffer,
+     * each chunk is then encoded into its own slot. As with exact_size, every element must report its exact size;
+     * if a chunk does not fill its slot exactly, or overruns it, the container is serialized again on the calling thread
+     * A checksum with combine() is computed by every task over its own slot while the other chunks are still encoded,
+     * other checksums and the encoder run on the calling thread once the payload is done
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Encoder = empty_encoder>
+    std::vector<uint8_t> serialize_parallel(const _Ty &value, _CheckSum checksum = empty_checksum{}, _Encoder encoder = empty_encoder{}, size_t threads = 0)
+    {
+        using value_type = typename _Ty::value_type;
+        using iterator_category = typename std::iterator_traits<typename _Ty::const_iterator>::iterator_category;
+
+        static_assert(is_sequence_container_v<_Ty> && std::is_base_of_v<std::random_access_iterator_tag, iterator_category>,
+                      "only random access sequence containers can be serialized in parallel");
+
+        if (threads == 0)
+            threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+        auto length = value.size();
+
+        auto chunks = (std::min)(threads * _parallel_chunks_per_thread, length / _parallel_min_chunk);
+
+        if (threads < 2 || chunks < 2)
+            return serialize(value, checksum, encoder);
+
+        auto chunk_begin = [length, chunks](size_t chunk)
+        {
+            return detail::chunk_begin(length, chunks, chunk);
+        };
+
+        // size of every chunk, then prefix-summed into its offset in the payload
+        std::vector<size_t> offsets(chunks + 1);
+
+        if constexpr (is_trivially_serializable_v<value_type>)
+        {
+            for (size_t i = 0; i < chunks; ++i)
+                offsets[i + 1] = (chunk_begin(i + 1) - chunk_begin(i)) * sizeof(value_type);
+        }
+        else
+        {
+            detail::parallel_for(chunks, threads, [&](size_t chunk)
+                                 {
+                size_t size{};
+
+                for (auto i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i)
+                    detail::get_element_size(value[i], size);
+
+                offsets[chunk + 1] = size; });
+        }
+
+        for (size_t i = 0; i < chunks; ++i)
+            offsets[i + 1] += offsets[i];
+
+        // same data header as the serial path of a sequence container
+        data_header _header{};
+
+        _header.set_main_type(d_seq_container);
+        _header.set_sub_type(get_data_type<value_type>());
+
+        auto container_header_size = detail::container_header_size(length);
+
+        auto payload_length = container_header_size + offsets[chunks];
+
+        auto header_size = detail::packer_header_size(payload_length);
+
+        auto payload_offset = header_size + container_header_size;
+
+        std::vector<uint8_t> data(payload_offset + offsets[chunks]);
+
+        bytes_writer_bounded header_writer{data.data() + header_size, container_header_size};
+
+        detail::write_container_header(header_writer, _header, length);
+
+        // one flag per chunk, std::vector<bool> could not be written from several threads
+        std::vector<uint8_t> filled(chunks);
+
+        constexpr bool _combine = has_checksum_combine_v<_CheckSum> && checksum_type_v<_CheckSum> != ct_none && codec_type_v<_Encoder> == cd_none;
+
+        std::vector<decltype(checksum(nullptr, 0))> checksums(_combine ? chunks : 0);
+
+        detail::parallel_for(chunks, threads, [&](size_t chunk)
+                             {
+            auto slot = data.data() + payload_offset + offsets[chunk];
+            auto slot_size = offsets[chunk + 1] - offsets[chunk];
+
+            bytes_writer_bounded writer{slot, slot_size};
+
+            auto first = chunk_begin(chunk);
+            auto last = chunk_begin(chunk + 1);
+
+            /* elements are stored as raw bytes, so the whole chunk can be copied at once */
+            if constexpr (is_contiguous_container_v<_Ty> && is_trivially_serializable_v<value_type>)
+            {
+                writer.write(reinterpret_cast<const uint8_t *>(value.data() + first), (last - first) * sizeof(value_type));
+            }
+            else
+            {
+                for (auto i = first; i < last; ++i)
+                    writer << value[i];
+            }
+
+            // every byte the chunk tried to write, the dropped ones included, must fill its slot exactly
+            filled[chunk] = writer.dropped() == 0 && writer.remaining() == 0;
+
+            // the slot is checksummed while it is still in cache
+            if constexpr (_combine)
+                checksums[chunk] = checksum(slot, slot_size); });
+
+        // get_size() reported too much or too little for some element
+        if (std::find(filled.begin(), filled.end(), uint8_t{0}) != filled.end())
+            return serialize(value, checksum, encoder);
+
+        if constexpr (codec_type_v<_Encoder> != cd_none)
+        {
+            return detail::encode_package(data.data() + header_size, payload_length, checksum, encoder);
+        }
+        else if constexpr (_combine)
+        {
+            auto crc = checksum(data.data() + header_size, container_header_size);
+
+            for (size_t i = 0; i < chunks; ++i)
+                crc = checksum.combine(crc, checksums[i], offsets[i + 1] - offsets[i]);
+
+            detail::write_packer_header<_CheckSum>(data.data(), payload_length, static_cast<std::uint64_t>(crc));
+        }
+        else
+        {
+            detail::patch_packer_header(data.data(), payload_length, checksum);
+        }
+
+        return data;
+    }
+
+    /*
+     * Deserialize a random access sequence container on `threads` threads (0 for one per core), each fills a disjoint slice of the resized container
+     * Write the container with `zpacker::indexed(container)`, its offset table tells where every slice starts;
+     * a container written without it is decoded on the calling thread
+     * A checksum with combine() is verified by parallel_checksum(), other checksums and the decoder run on the calling thread
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    _Ty deserialize_parallel(const void *buffer, size_t length, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{}, size_t threads = 0)
+    {
+        using iterator_category = typename std::iterator_traits<typename _Ty::iterator>::iterator_category;
+
+        static_assert(is_sequence_container_v<_Ty> && std::is_base_of_v<std::random_access_iterator_tag, iterator_category>,
+                      "only random access sequence containers can be deserialized in parallel");
+
+        if (threads == 0)
+            threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+        packer_header_large ph{};
+
+        auto data = static_cast<const uint8_t *>(buffer);
+
+        size_t header_size{};
+
+        // check header and checksum
+        if constexpr (has_checksum_combine_v<_CheckSum>)
+        {
+            header_size = detail::parse_packer_header<_CheckSum>(data, length, ph, codec_type_v<_Decoder>);
+
+            if (header_size == 0 || static_cast<std::uint64_t>(parallel_checksum(checksum, data + header_size, ph.length, threads)) != ph.crc.crc64)
+                return _Ty{};
+        }
+        else
+        {
+            header_size = detail::unpack_packer_header(data, length, checksum, ph, codec_type_v<_Decoder>);
+            if (header_size == 0)
+                return _Ty{};
+        }
+
+        std::vector<uint8_t> decoded{};
+
+        auto payload = data + header_size;
+        size_t payload_length = ph.length;
+
+        if constexpr (codec_type_v<_Decoder> != cd_none)
+        {
+            static_assert(!holds_view<_Ty>::value, "a view would refer to the temporary decoded buffer");
+
+            decoded = decoder(payload, payload_length);
+
+            payload = decoded.data();
+            payload_length = decoded.size();
+        }
+
+        bytes_reader_bounded reader{payload, payload_length};
+
+        data_header _header{};
+
+        memcpy(&_header, payload, (std::min)(payload_length, sizeof(data_header)));
+
+        /* without the offset table the start of a slice is only known once the ones before it are decoded */
+        if (payload_length < sizeof(data_header) || _header.get_main_type() != d_indexed || threads < 2)
+            return deserialize_object<_Ty>(reader);
+
+        // the element count may follow the data_header, see _large_length
+        bytes_reader_bounded index_reader{payload, payload_length};
+
+        auto lazy = index_reader.template read<lazy_container<_Ty>>();
+
+        auto chunks = (std::min)(threads * _parallel_chunks_per_thread, lazy.size() / _parallel_min_chunk);
+
+        if (chunks < 2)
+            return deserialize_object<_Ty>(reader);
+
+        _Ty container{};
+
+        container.resize(lazy.size());
+
+        // one flag per chunk, std::vector<bool> could not be written from several threads
+        std::vector<uint8_t> decoded_chunks(chunks);
+
+        detail::parallel_for(chunks, threads, [&](size_t chunk)
+                             {
+            auto first = detail::chunk_begin(lazy.size(), chunks, chunk);
+            auto last = detail::chunk_begin(lazy.size(), chunks, chunk + 1);
+
+            decoded_chunks[chunk] = lazy.decode(first, last, container.begin() + first); });
+
+        // the offset table is malformed
+        if (std::find(decoded_chunks.begin(), decoded_chunks.end(), uint8_t{0}) != decoded_chunks.end())
+            return _Ty{};
+
+        return container;
+    }
+
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder>
+    _Ty deserialize_parallel(const std::vector<uint8_t> &data, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{}, size_t threads = 0)
+    {
+        return deserialize_parallel<_Ty>(data.data(), data.size(), checksum, decoder, threads);
+    }
+}
@@ -0,0 +1,783 @@
+#pragma once
+
+/*
+ * Buffered streaming over file descriptors and iostreams, memory use does not depend on the size of the object
+ * Include zpacker.hpp or zpacker_20.hpp before this header to choose the language level, zpacker.hpp is used otherwise
+ */
+#if !defined(ZPACKER_HPP) && !defined(ZPACKER_20_HPP)
+#include "zpacker.hpp"
+#endif
+
+#include <ostream>
+#include <istream>
+#include <limits>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace zpacker
+{
+    constexpr size_t _default_stream_buffer_size = 64 * 1024;
+
+    namespace detail
+    {
+#if defined(_WIN32)
+        inline long long write_fd(int fd, const uint8_t *data, size_t length)
+        {
+            return _write(fd, data, static_cast<unsigned int>((std::min)(length, static_cast<size_t>(INT_MAX))));
+        }
+
+        inline long long seek_fd(int fd, long long offset, int origin)
+        {
+            return _lseeki64(fd, offset, origin);
+        }
+
+        inline long long read_fd(int fd, uint8_t *data, size_t length)
+        {
+            return _read(fd, data, static_cast<unsigned int>((std::min)(length, static_cast<size_t>(INT_MAX))));
+        }
+#else
+        inline long long write_fd(int fd, const uint8_t *data, size_t length)
+        {
+            return ::write(fd, data, length);
+        }
+
+        inline long long seek_fd(int fd, long long offset, int origin)
+        {
+            return lseek(fd, static_cast<off_t>(offset), origin);
+        }
+
+        inline long long read_fd(int fd, uint8_t *data, size_t length)
+        {
+            return ::read(fd, data, length);
+        }
+#endif
+
+        /*
+         * Write all `length` bytes to `fd`, partial writes and interrupts are retried
+         */
+        inline bool write_fd_all(int fd, const uint8_t *data, size_t length)
+        {
+            while (length > 0)
+            {
+                auto written = write_fd(fd, data, length);
+
+                if (written < 0 && errno == EINTR)
+                    continue;
+
+                if (written <= 0)
+                    return false;
+
+                data += written;
+                length -= static_cast<size_t>(written);
+            }
+
+            return true;
+        }
+    }
+
+    /*
+     * Writer that gathers the output in a fixed-size buffer and flushes it to a file descriptor or std::ostream when full
+     * Writes larger than the buffer go straight to the sink. Once the sink fails, the rest of the output is dropped,
+     * see good()
+     */
+    class stream_writer
+    {
+    public:
+        explicit stream_writer(std::ostream &os, size_t buffer_size = _default_stream_buffer_size)
+            : m_os(std::addressof(os)), m_buffer((std::max)(buffer_size, sizeof(packer_header)))
+        {
+            // -1 if the stream can not seek
+            m_origin = static_cast<long long>(os.tellp());
+        }
+
+        explicit stream_writer(int fd, size_t buffer_size = _default_stream_buffer_size)
+            : m_fd(fd), m_buffer((std::max)(buffer_size, sizeof(packer_header)))
+        {
+            // -1 for pipes and sockets
+            m_origin = detail::seek_fd(fd, 0, SEEK_CUR);
+        }
+
+        stream_writer(const stream_writer &) = delete;
+        stream_writer &operator=(const stream_writer &) = delete;
+
+        ~stream_writer()
+        {
+            flush();
+        }
+
+        template <class _Vty>
+        void write(const _Vty &val)
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                if (sizeof(_Vty) <= m_buffer.size() - m_used)
+                {
+                    memcpy(m_buffer.data() + m_used, std::addressof(val), sizeof(_Vty));
+
+                    m_used += sizeof(_Vty);
+                }
+                else
+                {
+                    write(reinterpret_cast<const uint8_t *>(std::addressof(val)), sizeof(_Vty));
+                }
+            }
+            else
+            {
+                serialize_object(*this, val);
+            }
+        }
+
+        void write(const std::vector<uint8_t> &data)
+        {
+            write(data.data(), data.size());
+        }
+
+        void write(const uint8_t *data, size_t length)
+        {
+            // an empty container may hand in a null `data`
+            if (m_failed || length == 0)
+                return;
+
+            if (length > m_buffer.size() - m_used)
+            {
+                if (!flush())
+                    return;
+
+                // too large to be worth a copy
+                if (length >= m_buffer.size())
+                {
+                    m_failed = !put(data, length);
+
+                    if (!m_failed)
+                        m_flushed += length;
+
+                    return;
+                }
+            }
+
+            memcpy(m_buffer.data() + m_used, data, length);
+
+            m_used += length;
+        }
+
+        template <class _Vty>
+        stream_writer &operator<<(const _Vty &val)
+        {
+            this->write(val);
+
+            return *this;
+        }
+
+        template <class _Ty>
+        bool can_write() const
+        {
+            return !m_failed;
+        }
+
+        /*
+         * Get the total bytes written, flushed or not
+         */
+        size_t count() const
+        {
+            return m_flushed + m_used;
+        }
+
+        /*
+         * Bytes that can be written before the buffer is flushed
+         */
+        size_t remaining() const
+        {
+            return m_buffer.size() - m_used;
+        }
+
+        bool good() const
+        {
+            return !m_failed;
+        }
+
+        /*
+         * Whether flushed bytes can still be patched, pipes and sockets can not seek
+         */
+        bool seekable() const
+        {
+            return m_origin >= 0;
+        }
+
+        /*
+         * Pass the buffered bytes to the sink
+         */
+        bool flush()
+        {
+            if (m_failed)
+                return false;
+
+            if (m_used > 0)
+            {
+                m_failed = !put(m_buffer.data(), m_used);
+
+                if (m_failed)
+                    return false;
+
+                m_flushed += m_used;
+                m_used = 0;
+            }
+
+            if (m_os != nullptr)
+                m_os->flush();
+
+            return true;
+        }
+
+        /*
+         * Overwrite `length` bytes written at `offset` (in count() units), e.g. a length or header that is only known later
+         * Bytes still in the buffer are patched in place, flushed bytes need a sink that can seek
+         */
+        bool patch(size_t offset, const uint8_t *data, size_t length)
+        {
+            if (m_failed || offset + length > count())
+                return false;
+
+            if (offset >= m_flushed)
+            {
+                memcpy(m_buffer.data() + (offset - m_flushed), data, length);
+
+                return true;
+            }
+
+            // a patch spanning the flushed and the buffered bytes is rare, so the buffer is flushed first
+            if (offset + length > m_flushed && !flush())
+                return false;
+
+            if (m_origin < 0)
+                return false;
+
+            auto position = m_origin + static_cast<long long>(offset);
+            auto end = m_origin + static_cast<long long>(m_flushed);
+
+            if (m_os != nullptr)
+            {
+                m_os->seekp(position);
+                m_os->write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
+                m_os->seekp(end);
+
+                return m_os->good();
+            }
+
+            return detail::seek_fd(m_fd, position, SEEK_SET) == position &&
+                   detail::write_fd_all(m_fd, data, length) &&
+                   detail::seek_fd(m_fd, end, SEEK_SET) == end;
+        }
+
+    private:
+        bool put(const uint8_t *data, size_t length)
+        {
+            if (m_os != nullptr)
+            {
+                m_os->write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
+
+                return m_os->good();
+            }
+
+            return detail::write_fd_all(m_fd, data, length);
+        }
+
+        std::ostream *m_os{nullptr};
+        int m_fd{-1};
+        long long m_origin{-1};
+        std::vector<uint8_t> m_buffer;
+        size_t m_used{0};
+        size_t m_flushed{0};
+        bool m_failed{false};
+    };
+
+    /*
+     * Serialize a package to `writer` in constant memory, the checksum is updated while the payload is written
+     * The length of the payload is taken from get_size(), so the packer header is written in front of it right away.
+     * A checksum is only known once the payload is done and is patched into the header, so on a sink that can not seek
+     * the whole package has to fit in the buffer; nothing is written and false is returned otherwise
+     * Return false as well if the package could not be written completely
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum>
+    bool serialize_stream(stream_writer &writer, const _Ty &value, _CheckSum checksum = empty_checksum{})
+    {
+        auto start = writer.count();
+
+        auto length = get_size(value);
+
+        auto header_size = detail::packer_header_size(length);
+
+        if constexpr (checksum_type_v<_CheckSum> != ct_none)
+        {
+            // the header must still be in the buffer when the payload is done
+            if (!writer.seekable() && header_size + length > writer.remaining() &&
+                (!writer.flush() || header_size + length > writer.remaining()))
+                return false;
+        }
+
+        uint8_t header[sizeof(packer_header_large)];
+
+        detail::write_packer_header<_CheckSum>(header, length, 0);
+
+        writer.write(header, header_size);
+
+        std::uint64_t crc{};
+
+        if constexpr (checksum_type_v<_CheckSum> == ct_none)
+        {
+            serialize_object(writer, value);
+        }
+        else
+        {
+            static_assert(detail::fuse_checksum_v<_CheckSum>, "the checksum must implement init/update/finalize to be computed on a stream");
+
+            checksum_writer<stream_writer, _CheckSum> checked{writer, checksum};
+
+            serialize_object(checked, value);
+
+            crc = static_cast<std::uint64_t>(checked.checksum());
+        }
+
+        auto written = writer.count() - start - header_size;
+
+        if (checksum_type_v<_CheckSum> == ct_none && written == length)
+            return writer.flush();
+
+        // get_size() was not exact, the header can only be corrected if it keeps its size
+        if (detail::packer_header_size(written) != header_size)
+            return false;
+
+        detail::write_packer_header<_CheckSum>(header, written, crc);
+
+        return writer.patch(start, header, header_size) && writer.flush();
+    }
+
+    /*
+     * Reader over a refillable window that pulls from a file descriptor or std::istream as the read position advances
+     * The window is refilled with up to `read_ahead` bytes at a time, a value larger than the window grows it
+     * How much is left is unknown until the source is exhausted, set_limit() bounds the reader to a known length
+     */
+    class stream_reader
+    {
+    public:
+        explicit stream_reader(std::istream &is, size_t read_ahead = _default_stream_buffer_size)
+            : m_is(std::addressof(is)), m_buffer((std::max)(read_ahead, sizeof(packer_header)))
+        {
+        }
+
+        explicit stream_reader(int fd, size_t read_ahead = _default_stream_buffer_size)
+            : m_fd(fd), m_buffer((std::max)(read_ahead, sizeof(packer_header)))
+        {
+        }
+
+        stream_reader(const stream_reader &) = delete;
+        stream_reader &operator=(const stream_reader &) = delete;
+
+        template <class _Vty>
+        _Vty read()
+        {
+            if constexpr (is_trivially_serializable_v<_Vty>)
+            {
+                static_assert(std::is_default_constructible_v<_Vty>, "_Vty must be default constructible");
+
+                std::remove_cv_t<_Vty> result{};
+
+                if (!fill(sizeof(_Vty)))
+                    return result;
+
+                memcpy(std::addressof(result), m_buffer.data() + m_pos, sizeof(_Vty));
+
+                m_pos += sizeof(_Vty);
+
+                return result;
+            }
+            else
+            {
+                return deserialize_object<_Vty>(*this);
+            }
+        }
+
+        template <class _Vty>
+        stream_reader &operator>>(_Vty &val)
+        {
+            val = this->read<_Vty>();
+
+            return *this;
+        }
+
+        std::vector<uint8_t> read_bytes(size_t count)
+        {
+            std::vector<uint8_t> result{};
+
+            count = (std::min)(count, remaining());
+
+            while (count > 0 && fill(1))
+            {
+                auto piece = (std::min)(count, m_end - m_pos);
+
+                result.insert(result.end(), m_buffer.data() + m_pos, m_buffer.data() + m_pos + piece);
+
+                m_pos += piece;
+                count -= piece;
+            }
+
+            return result;
+        }
+
+        /*
+         * Copy `length` bytes out to `data`, nothing is read if there are not enough bytes remaining
+         * If the source ends early the bytes up to there are consumed and false is returned
+         */
+        bool read(uint8_t *data, size_t length)
+        {
+            // an empty container may hand in a null `data`
+            if (length == 0)
+                return true;
+
+            if (remaining() < length)
+                return false;
+
+            auto piece = (std::min)(length, m_end - m_pos);
+
+            memcpy(data, m_buffer.data() + m_pos, piece);
+
+            m_pos += piece;
+            data += piece;
+            length -= piece;
+
+            if (length == 0)
+                return true;
+
+            // too large to be worth a copy, the drained window is bypassed
+            if (length >= m_buffer.size())
+            {
+                m_base += m_end;
+                m_pos = m_end = 0;
+
+                while (length > 0)
+                {
+                    auto got = get(data, length, length);
+
+                    if (got == 0)
+                        return false;
+
+                    m_base += got;
+                    data += got;
+                    length -= got;
+                }
+
+                return true;
+            }
+
+            if (!fill(length))
+                return false;
+
+            memcpy(data, m_buffer.data() + m_pos, length);
+
+            m_pos += length;
+
+            return true;
+        }
+
+        template <class _Vty, std::enable_if_t<std::is_trivially_copyable_v<_Vty>, int> = 0>
+        bool can_read() const
+        {
+            return remaining() >= sizeof(_Vty);
+        }
+
+        /*
+         * Bytes left up to the limit, exact once the source is exhausted
+         */
+        size_t remaining() const
+        {
+            auto result = m_limit - count();
+
+            if (m_eof)
+                result = (std::min)(result, m_end - m_pos);
+
+            return result;
+        }
+
+        /*
+         * Return total bytes that has been read out for now
+         */
+        size_t count() const
+        {
+            return m_base + m_pos;
+        }
+
+        void skip(size_t count)
+        {
+            if (remaining() < count)
+                return;
+
+            while (count > 0)
+            {
+                if (m_pos == m_end && !fill(1))
+                    return;
+
+                auto piece = (std::min)(count, m_end - m_pos);
+
+                m_pos += piece;
+                count -= piece;
+            }
+        }
+
+        /*
+         * Only forward seeks are supported, the bytes in between are skipped
+         */
+        void seek(size_t pos)
+        {
+            if (pos >= count())
+                skip(pos - count());
+        }
+
+        /*
+         * Pull the next `length` bytes into the window without consuming them
+         * Return nullptr if the source ends before
+         */
+        const uint8_t *peek(size_t length)
+        {
+            return fill(length) ? m_buffer.data() + m_pos : nullptr;
+        }
+
+        /*
+         * Bound the reader to the next `length` bytes, e.g. the payload of a package
+         */
+        void set_limit(size_t length)
+        {
+            m_limit = count() + length;
+        }
+
+        void clear_limit()
+        {
+            m_limit = (std::numeric_limits<size_t>::max)();
+        }
+
+        bool good() const
+        {
+            return !m_failed;
+        }
+
+    private:
+        /*
+         * Make sure at least `length` bytes are in the window, the unread bytes are moved to the front before a refill
+         */
+        bool fill(size_t length)
+        {
+            if (m_end - m_pos >= length)
+                return true;
+
+            if (remaining() < length)
+                return false;
+
+            memmove(m_buffer.data(), m_buffer.data() + m_pos, m_end - m_pos);
+
+            m_base += m_pos;
+            m_end -= m_pos;
+            m_pos = 0;
+
+            if (length > m_buffer.size())
+                m_buffer.resize(length);
+
+            while (m_end < length)
+            {
+                auto got = get(m_buffer.data() + m_end, m_buffer.size() - m_end, length - m_end);
+
+                if (got == 0)
+                    return false;
+
+                m_end += got;
+            }
+
+            return true;
+        }
+
+        /*
+         * Pull up to `length` bytes from the source, waiting for no more than `needed` of them
+         * Return 0 once it is exhausted or fails
+         */
+        size_t get(uint8_t *data, size_t length, size_t needed)
+        {
+            if (m_eof)
+                return 0;
+
+            if (m_is != nullptr)
+            {
+                // only `needed` bytes are waited for, the rest is what the stream has buffered already
+                m_is->read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(needed));
+
+                auto got = static_cast<size_t>(m_is->gcount());
+
+                if (got < needed)
+                {
+                    m_eof = true;
+                    m_failed = m_is->bad();
+
+                    return got;
+                }
+
+                if (length > needed)
+                    got += static_cast<size_t>(m_is->readsome(reinterpret_cast<char *>(data) + needed, static_cast<std::streamsize>(length - needed)));
+
+                return got;
+            }
+
+            for (;;)
+            {
+                auto got = detail::read_fd(m_fd, data, length);
+
+                if (got < 0 && errno == EINTR)
+                    continue;
+
+                if (got <= 0)
+                {
+                    m_eof = true;
+                    m_failed = got < 0;
+
+                    return 0;
+                }
+
+                return static_cast<size_t>(got);
+            }
+        }
+
+        std::istream *m_is{nullptr};
+        int m_fd{-1};
+        std::vector<uint8_t> m_buffer;
+        size_t m_pos{0};
+        size_t m_end{0};
+        size_t m_base{0};
+        size_t m_limit{(std::numeric_limits<size_t>::max)()};
+        bool m_eof{false};
+        bool m_failed{false};
+    };
+
+    namespace detail
+    {
+        /*
+         * Pull the packer header at the read position of `reader` into its window without consuming it
+         * Only the bytes its version needs are waited for, so a short package on a pipe that stays open is not stuck
+         * Return nullptr if the source ends before or the version is unknown, `size` is the size of the header otherwise
+         */
+        inline const uint8_t *peek_packer_header(stream_reader &reader, size_t &size)
+        {
+            std::uint16_t version{};
+
+            auto data = reader.peek(sizeof(version));
+            if (data == nullptr)
+                return nullptr;
+
+            memcpy(&version, data, sizeof(version));
+
+            if (version == VERSION)
+            {
+                data = reader.peek(sizeof(packer_header));
+                if (data == nullptr)
+                    return nullptr;
+
+                size = data[offsetof(packer_header, flags)] & _flag_large ? sizeof(packer_header_large) : sizeof(packer_header);
+            }
+            else if (version == VERSION_1)
+            {
+                size = sizeof(packer_header_v1);
+            }
+            else
+            {
+                return nullptr;
+            }
+
+            return reader.peek(size);
+        }
+    }
+
+    /*
+     * Deserialize a package from `reader` in bounded memory, the payload is parsed straight out of the window
+     * The reader is left behind the package, so packages written back to back can be read one after another
+     * A codec, or a checksum that can not be updated on the fly, needs the whole payload in memory
+     */
+    template <
+        class _Ty,
+        class _CheckSum = empty_checksum,
+        class _Decoder = empty_decoder,
+        std::enable_if_t<std::is_default_constructible_v<_Ty>, int> = 0>
+    _Ty deserialize_stream(stream_reader &reader, _CheckSum checksum = empty_checksum{}, _Decoder decoder = empty_decoder{})
+    {
+        static_assert(!holds_view<_Ty>::value, "a view would refer to the window of the reader, which is refilled");
+
+        size_t header_size{};
+
+        auto header = detail::peek_packer_header(reader, header_size);
+
+        packer_header_large ph{};
+
+        // the payload length is checked against the stream as it is read
+        if (header == nullptr || detail::read_packer_header<_CheckSum>(header, header_size, ph, codec_type_v<_Decoder>) == 0)
+            return _Ty{};
+
+        reader.skip(header_size);
+
+        if constexpr (codec_type_v<_Decoder> != cd_none || (!detail::fuse_checksum_v<_CheckSum> && checksum_type_v<_CheckSum> != ct_none))
+        {
+            auto payload = reader.read_bytes(ph.length);
+
+            // check checksum
+            if (payload.size() != ph.length || static_cast<std::uint64_t>(checksum(payload.data(), payload.size())) != ph.crc.crc64)
+                return _Ty{};
+
+            if constexpr (codec_type_v<_Decoder> != cd_none)
+            {
+                return detail::deserialize_decoded<_Ty>(payload.data(), payload.size(), decoder);
+            }
+            else
+            {
+                bytes_reader payload_reader{payload};
+
+                return deserialize_object<_Ty>(payload_reader);
+            }
+        }
+        else
+        {
+            auto end = reader.count() + ph.length;
+
+            reader.set_limit(ph.length);
+
+            _Ty result{};
+            bool passed = true;
+
+            if constexpr (detail::fuse_checksum_v<_CheckSum>)
+            {
+                checksum_reader<stream_reader, _CheckSum> checked{reader, checksum};
+
+                result = deserialize_object<_Ty>(checked);
+
+                // trailing bytes are part of the checksum as well
+                checked.skip(checked.remaining());
+
+                passed = static_cast<std::uint64_t>(checked.checksum()) == ph.crc.crc64;
+            }
+            else
+            {
+                result = deserialize_object<_Ty>(reader);
+
+                reader.skip(reader.remaining());
+            }
+
+            reader.clear_limit();
+
+            // the source ended inside the payload
+            if (!passed || reader.count() != end)
+                return _Ty{};
+
+            return result;
+        }
+    }
+}